@@ -5,53 +5,17 @@
 #include "XSUB.h"
 #include "ppport.h"
 
-#include "src/sha3nist.c"
-#include "src/jh.c"
-
-static int
-hex_encode (char *dest, const unsigned char *src, int len) {
-    static const char hex[] = "0123456789abcdef";
-    char *p = dest;
-    const unsigned char *s = src;
-    for (; len--; s++) {
-        *p++ = hex[s[0] >> 4];
-        *p++ = hex[s[0] & 0x0f];
-    }
-    return (int)(p - dest);
-}
+#include "src/libjh.h"
+#include "src/stats.h"
+#include "src/probes.h"
 
-static int
-base64_encode (char *dest, const unsigned char *src, int len) {
-    static const char b64[] =
-        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-    char *p = dest;
-    const unsigned char *s = src;
-    const unsigned char *end = src + len - 2;
-
-    for (; s < end; s += 3) {
-        *p++ = b64[s[0] >> 2];
-        *p++ = b64[((s[0] & 3) << 4) + (s[1] >> 4)];
-        *p++ = b64[((s[1] & 0xf) << 2) + (s[2] >> 6)];
-        *p++ = b64[s[2] & 0x3f];
-    }
-    switch (len % 3) {
-    case 1:
-        *p++ = b64[s[0] >> 2];
-        *p++ = b64[(s[0] & 3) << 4];
-        break;
-    case 2:
-        *p++ = b64[s[0] >> 2];
-        *p++ = b64[((s[0] & 3) << 4) + (s[1] >> 4)];
-        *p++ = b64[((s[1] & 0xf) << 2)];
-        break;
-    }
-    return (int)(p - dest);
-}
+#include "src/sha3nist.c"
+#include "src/encode.c"
 
 static SV *
 make_mortal_sv(pTHX_ const unsigned char *src, int bitlen, int enc) {
     char result[128];
-    char *ret;
+    char *ret = result;
     int len = bitlen >> 3;
 
     switch (enc) {
@@ -60,17 +24,138 @@ make_mortal_sv(pTHX_ const unsigned char *src, int bitlen, int enc) {
         break;
     case 1:
         len = hex_encode(result, src, len);
-        ret = result;
         break;
     case 2:
-        len = base64_encode(result, src, len);
-        ret = result;
+    case 3:
+        len = base64_encode(result, src, len, enc == 3);
         break;
     }
     return sv_2mortal(newSVpv(ret, len));
 }
 
-typedef hashState *Digest__JH;
+/*
+ * Computes the digest of the data added so far without disturbing the
+ * running state: the close runs on a copy of the sphlib context on the
+ * stack, so no hashState is allocated or copied.
+ */
+static HashReturn
+peek_final (const hashState *state, BitSequence *hashval) {
+    sph_jh_context sc;
+
+    if (state->output_computed) {
+        memcpy(hashval, state->output, state->hashbitlen >> 3);
+        return SUCCESS;
+    }
+    /* The context type is the same for every output size. */
+    sc = state->u.ctx512;
+    switch (state->hashbitlen) {
+    case 224:
+        sph_jh224_close(&sc, hashval);
+        break;
+    case 256:
+        sph_jh256_close(&sc, hashval);
+        break;
+    case 384:
+        sph_jh384_close(&sc, hashval);
+        break;
+    case 512:
+        sph_jh512_close(&sc, hashval);
+        break;
+    default:
+        return FAIL;
+    }
+    return SUCCESS;
+}
+
+/*
+ * Objects defer initialization of the hash state: new and reset only
+ * record the output size, and the IV is loaded when the state is next
+ * used. No reset is needed after a digest, since the sphlib close
+ * already leaves the context initialized.
+ */
+typedef struct {
+    hashState state;
+    int pending_init;
+} jh_object;
+
+static int
+valid_hashbitlen (int hashbitlen) {
+    switch (hashbitlen) {
+    case 224: case 256: case 384: case 512:
+        return 1;
+    }
+    return 0;
+}
+
+static void
+lazy_reset (jh_object *obj, int hashbitlen) {
+    obj->state.hashbitlen = hashbitlen;
+    obj->pending_init = 1;
+}
+
+static hashState *
+live_state (jh_object *obj) {
+    if (obj->pending_init) {
+        Init(&obj->state, obj->state.hashbitlen);
+        obj->pending_init = 0;
+    }
+    return &obj->state;
+}
+
+/*
+ * Serialized state: the magic bytes "JH", a format version, the output
+ * size in bytes, then the sphlib context image.
+ */
+#define FREEZE_VERSION 1
+#define FREEZE_HEADER 4
+#define FREEZE_MAX (FREEZE_HEADER + SPH_JH_EXPORT_MAX)
+
+static int
+freeze_state (const hashState *state, unsigned char *dest) {
+    /* A trailing partial byte has already closed the computation. */
+    if (state->output_computed)
+        return 0;
+    dest[0] = 'J';
+    dest[1] = 'H';
+    dest[2] = FREEZE_VERSION;
+    dest[3] = (unsigned char)(state->hashbitlen >> 3);
+    return FREEZE_HEADER + (int)sph_jh_export(&state->u, dest + FREEZE_HEADER);
+}
+
+static int
+thaw_state (hashState *state, const unsigned char *src, STRLEN len) {
+    int hashbitlen;
+
+    if (len < FREEZE_HEADER || src[0] != 'J' || src[1] != 'H'
+        || src[2] != FREEZE_VERSION)
+        return 0;
+    hashbitlen = src[3] << 3;
+    if (! valid_hashbitlen(hashbitlen))
+        return 0;
+    len -= FREEZE_HEADER;
+    if (sph_jh_import(&state->u, src + FREEZE_HEADER, len) != len)
+        return 0;
+    state->hashbitlen = hashbitlen;
+    state->output_computed = 0;
+    return 1;
+}
+
+/* jh_pieces_reader over a Perl filehandle */
+static long
+perlio_reader (void *ctx, void *buf, size_t len) {
+    dTHX;
+    SSize_t n = PerlIO_read((PerlIO *)ctx, buf, len);
+    if (n < 0 || (n == 0 && PerlIO_error((PerlIO *)ctx)))
+        return -1;
+    return (long)n;
+}
+
+typedef jh_object *Digest__JH;
+typedef jh_hmac_context *Digest__JH__HMAC;
+typedef jh_prefix_cache *Digest__JH__PrefixCache;
+typedef jh_drbg *Digest__JH__DRBG;
+typedef sph_jh_fixed *Digest__JH__Fixed;
+typedef jh_merkle *Digest__JH__MerkleLog;
 
 MODULE = Digest::JH    PACKAGE = Digest::JH
 
@@ -113,14 +198,235 @@ CODE:
     ST(0) = make_mortal_sv(aTHX_ result, bitlen, ix % 3);
     XSRETURN(1);
 
+void
+_pbkdf2 (passwords, salt, iterations, dklen, hashsize)
+    AV *passwords
+    SV *salt
+    UV iterations
+    UV dklen
+    int hashsize
+PREINIT:
+    const void **pw;
+    size_t *pw_len;
+    unsigned char *dk;
+    const char *s;
+    SSize_t i, n;
+    SV **svp;
+    STRLEN len, salt_len;
+PPCODE:
+    n = av_len(passwords) + 1;
+    if (! n || ! valid_hashbitlen(hashsize) || ! iterations
+        || JH_PBKDF2_TOO_LONG(dklen, (UV)(hashsize >> 3))
+        || dklen > ((size_t)-1 - 1) / (size_t)n)
+        XSRETURN_EMPTY;
+    s = SvPV(salt, salt_len);
+    Newx(pw, n, const void *);
+    SAVEFREEPV(pw);
+    Newx(pw_len, n, size_t);
+    SAVEFREEPV(pw_len);
+    Newx(dk, n * dklen + 1, unsigned char);
+    SAVEFREEPV(dk);
+    for (i = 0; i < n; i++) {
+        svp = av_fetch(passwords, i, 0);
+        if (svp)
+            pw[i] = SvPV(*svp, len);
+        else {
+            pw[i] = "";
+            len = 0;
+        }
+        pw_len[i] = len;
+    }
+    if (jh_pbkdf2(hashsize, pw, pw_len, n, s, salt_len, iterations, dk,
+            dklen) < 0)
+        croak("Out of memory");
+    EXTEND(SP, n);
+    for (i = 0; i < n; i++)
+        PUSHs(sv_2mortal(newSVpvn((char *)dk + i * dklen, dklen)));
+
+void
+_chain (seeds, count, hashsize)
+    AV *seeds
+    UV count
+    int hashsize
+PREINIT:
+    sph_jh_context start;
+    const sph_jh_context **starts;
+    const void **data;
+    size_t *data_len, out_len;
+    unsigned char *buf;
+    SSize_t i, n;
+    SV **svp;
+    STRLEN len;
+PPCODE:
+    n = av_len(seeds) + 1;
+    if (! n || ! valid_hashbitlen(hashsize))
+        XSRETURN_EMPTY;
+    out_len = hashsize >> 3;
+    Newx(starts, n, const sph_jh_context *);
+    SAVEFREEPV(starts);
+    Newx(data, n, const void *);
+    SAVEFREEPV(data);
+    Newx(data_len, n, size_t);
+    SAVEFREEPV(data_len);
+    Newx(buf, n * out_len, unsigned char);
+    SAVEFREEPV(buf);
+    sph_jh_init_size(&start, hashsize);
+    for (i = 0; i < n; i++) {
+        svp = av_fetch(seeds, i, 0);
+        if (svp)
+            data[i] = SvPV(*svp, len);
+        else {
+            data[i] = "";
+            len = 0;
+        }
+        data_len[i] = len;
+        starts[i] = &start;
+    }
+    EXTEND(SP, n);
+    if (! count) {
+        for (i = 0; i < n; i++)
+            PUSHs(sv_2mortal(newSVpvn(data[i], data_len[i])));
+        XSRETURN(n);
+    }
+    /* The seeds may have any length; the steps after the first don't. */
+    sph_jh_multi_close(starts, data, data_len, n, buf, hashsize);
+    sph_jh_chain(buf, n, count - 1, hashsize);
+    for (i = 0; i < n; i++)
+        PUSHs(sv_2mortal(newSVpvn((char *)buf + i * out_len, out_len)));
+
+SV *
+_pieces (fh, piece_size, hashsize, threads)
+    PerlIO *fh
+    UV piece_size
+    int hashsize
+    unsigned threads
+PREINIT:
+    unsigned char *digests;
+    long n;
+CODE:
+    n = jh_pieces(perlio_reader, fh, piece_size, hashsize, threads,
+        &digests);
+    if (n < 0)
+        XSRETURN_UNDEF;
+    RETVAL = newSVpvn(n ? (char *)digests : "", n * (hashsize >> 3));
+    free(digests);
+OUTPUT:
+    RETVAL
+
+SV *
+_chunks (fh, min, avg, max, hashsize, threads)
+    PerlIO *fh
+    UV min
+    UV avg
+    UV max
+    int hashsize
+    unsigned threads
+PREINIT:
+    unsigned char *digests;
+    size_t *lengths, offset = 0, out_len = hashsize >> 3;
+    long n, i;
+    AV *chunks, *chunk;
+CODE:
+    n = jh_chunks(perlio_reader, fh, min, avg, max, hashsize, threads,
+        &lengths, &digests);
+    if (n < 0)
+        XSRETURN_UNDEF;
+    chunks = newAV();
+    av_extend(chunks, n);
+    for (i = 0; i < n; i++) {
+        chunk = newAV();
+        av_extend(chunk, 2);
+        av_push(chunk, newSVuv(offset));
+        av_push(chunk, newSVuv(lengths[i]));
+        av_push(chunk, newSVpvn((char *)digests + i * out_len, out_len));
+        av_push(chunks, newRV_noinc((SV *)chunk));
+        offset += lengths[i];
+    }
+    free(lengths);
+    free(digests);
+    RETVAL = newRV_noinc((SV *)chunks);
+OUTPUT:
+    RETVAL
+
+SV *
+_hkdf_extract (ikm, salt, hashsize)
+    SV *ikm
+    SV *salt
+    int hashsize
+PREINIT:
+    const char *k, *s;
+    STRLEN klen, slen;
+    unsigned char prk[64];
+CODE:
+    k = SvPV(ikm, klen);
+    s = SvPV(salt, slen);
+    if (jh_hkdf_extract(hashsize, s, slen, k, klen, prk) < 0)
+        XSRETURN_UNDEF;
+    RETVAL = newSVpvn((char *)prk, hashsize >> 3);
+OUTPUT:
+    RETVAL
+
+SV *
+_hkdf_expand (prk, info, length, hashsize)
+    SV *prk
+    SV *info
+    UV length
+    int hashsize
+PREINIT:
+    const char *p, *i;
+    STRLEN plen, ilen;
+CODE:
+    /* the RFC 5869 limit, checked before allocating */
+    if (! valid_hashbitlen(hashsize) || length > 255 * (UV)(hashsize >> 3))
+        XSRETURN_UNDEF;
+    p = SvPV(prk, plen);
+    i = SvPV(info, ilen);
+    RETVAL = newSV(length + 1);
+    if (jh_hkdf_expand(hashsize, p, plen, i, ilen, SvPVX(RETVAL), length)
+            < 0) {
+        SvREFCNT_dec(RETVAL);
+        XSRETURN_UNDEF;
+    }
+    SvCUR_set(RETVAL, length);
+    SvPOK_only(RETVAL);
+OUTPUT:
+    RETVAL
+
+SV *
+stats ()
+ALIAS:
+    reset_stats = 1
+PREINIT:
+#ifdef JH_STATS
+    unsigned long long v[JH_STAT_COUNT];
+    HV *hv;
+    int k;
+#endif
+CODE:
+#ifdef JH_STATS
+    jh_stats_read(v, ix);
+    hv = newHV();
+    for (k = 0; k < JH_STAT_COUNT; k++)
+        (void)hv_store(hv, jh_stat_names[k], strlen(jh_stat_names[k]),
+            v[k] <= (UV)-1 ? newSVuv((UV)v[k]) : newSVnv((NV)v[k]), 0);
+    RETVAL = newRV_noinc((SV *)hv);
+#else
+    XSRETURN_UNDEF;
+#endif
+OUTPUT:
+    RETVAL
+
 Digest::JH
 new (class, hashsize)
     SV *class
     int hashsize
 CODE:
-    Newx(RETVAL, 1, hashState);
-    if (Init(RETVAL, hashsize) != SUCCESS)
+    if (! valid_hashbitlen(hashsize))
         XSRETURN_UNDEF;
+    Newx(RETVAL, 1, jh_object);
+    JH_STAT_ADD(JH_STAT_CTX_ALLOC, 1);
+    JH_PROBE2(context_create, RETVAL, hashsize);
+    lazy_reset(RETVAL, hashsize);
 OUTPUT:
     RETVAL
 
@@ -128,8 +434,10 @@ Digest::JH
 clone (self)
     Digest::JH self
 CODE:
-    Newx(RETVAL, 1, hashState);
-    Copy(self, RETVAL, 1, hashState);
+    Newx(RETVAL, 1, jh_object);
+    JH_STAT_ADD(JH_STAT_CTX_ALLOC, 1);
+    Copy(self, RETVAL, 1, jh_object);
+    JH_PROBE2(context_create, RETVAL, RETVAL->state.hashbitlen);
 OUTPUT:
     RETVAL
 
@@ -137,8 +445,7 @@ void
 reset (self)
     Digest::JH self
 PPCODE:
-    if (Init(self, self->hashbitlen) != SUCCESS)
-        XSRETURN_UNDEF;
+    lazy_reset(self, self->state.hashbitlen);
     XSRETURN(1);
 
 int
@@ -147,7 +454,7 @@ hashsize(self)
 ALIAS:
     algorithm = 1
 CODE:
-    RETVAL = self->hashbitlen;
+    RETVAL = self->state.hashbitlen;
 OUTPUT:
     RETVAL
 
@@ -155,14 +462,18 @@ void
 add (self, ...)
     Digest::JH self
 PREINIT:
+    hashState *state;
     int i;
     unsigned char *data;
     STRLEN len;
 PPCODE:
+    state = live_state(self);
     for (i = 1; i < items; i++) {
         data = (unsigned char *)(SvPV(ST(i), len));
-        if (Update(self, data, len << 3) != SUCCESS)
+        JH_PROBE2(add, self, len);
+        if (Update(state, data, len << 3) != SUCCESS)
             XSRETURN_UNDEF;
+        JH_PROBE2(add_done, self, len);
     }
     XSRETURN(1);
 
@@ -181,7 +492,7 @@ PPCODE:
     data = (unsigned char *)(SvPV(msg, len));
     if (bitlen > len << 3)
         bitlen = len << 3;
-    if (Update(self, data, bitlen) != SUCCESS)
+    if (Update(live_state(self), data, bitlen) != SUCCESS)
         XSRETURN_UNDEF;
     XSRETURN(1);
 
@@ -192,17 +503,791 @@ ALIAS:
     digest = 0
     hexdigest = 1
     b64digest = 2
+    base64_padded_digest = 3
 PREINIT:
     unsigned char result[64];
+    hashState *state;
 CODE:
-    if (Final(self, result) != SUCCESS)
+    state = live_state(self);
+    if (Final(state, result) != SUCCESS)
         XSRETURN_UNDEF;
-    Init(self, self->hashbitlen);
-    ST(0) = make_mortal_sv(aTHX_ result, self->hashbitlen, ix);
+    state->output_computed = 0;
+    ST(0) = make_mortal_sv(aTHX_ result, state->hashbitlen, ix);
+    XSRETURN(1);
+
+void *
+peek_digest (self)
+    Digest::JH self
+ALIAS:
+    peek_digest = 0
+    peek_hexdigest = 1
+    peek_b64digest = 2
+PREINIT:
+    unsigned char result[64];
+    hashState *state;
+CODE:
+    state = live_state(self);
+    if (peek_final(state, result) != SUCCESS)
+        XSRETURN_UNDEF;
+    ST(0) = make_mortal_sv(aTHX_ result, state->hashbitlen, ix);
     XSRETURN(1);
 
+void
+digest_suffixes (self, suffixes)
+    Digest::JH self
+    AV *suffixes
+ALIAS:
+    digest_suffixes = 0
+    hexdigest_suffixes = 1
+    b64digest_suffixes = 2
+PREINIT:
+    hashState *state;
+    const sph_jh_context **starts;
+    const void **data;
+    size_t *lens;
+    unsigned char *out;
+    SSize_t i, n;
+    SV **svp;
+    STRLEN len;
+    int bytes;
+PPCODE:
+    state = live_state(self);
+    if (state->output_computed)
+        XSRETURN_UNDEF;
+    n = av_len(suffixes) + 1;
+    if (! n)
+        XSRETURN_EMPTY;
+    bytes = state->hashbitlen >> 3;
+    Newx(starts, n, const sph_jh_context *);
+    SAVEFREEPV(starts);
+    Newx(data, n, const void *);
+    SAVEFREEPV(data);
+    Newx(lens, n, size_t);
+    SAVEFREEPV(lens);
+    Newx(out, n * bytes, unsigned char);
+    SAVEFREEPV(out);
+    for (i = 0; i < n; i++) {
+        svp = av_fetch(suffixes, i, 0);
+        if (svp)
+            data[i] = SvPV(*svp, len);
+        else {
+            data[i] = "";
+            len = 0;
+        }
+        lens[i] = len;
+        starts[i] = &state->u.ctx512;
+    }
+    sph_jh_multi_close(starts, data, lens, n, out, state->hashbitlen);
+    EXTEND(SP, n);
+    for (i = 0; i < n; i++)
+        PUSHs(make_mortal_sv(aTHX_ out + i * bytes, state->hashbitlen, ix));
+
+SV *
+freeze (self)
+    Digest::JH self
+PREINIT:
+    unsigned char buf[FREEZE_MAX];
+    int len;
+CODE:
+    len = freeze_state(live_state(self), buf);
+    if (! len)
+        XSRETURN_UNDEF;
+    RETVAL = newSVpvn((char *)buf, len);
+OUTPUT:
+    RETVAL
+
+SV *
+bytes_hashed (self)
+    Digest::JH self
+PREINIT:
+    hashState *state;
+    const sph_jh_context *sc;
+CODE:
+    state = live_state(self);
+    if (state->output_computed)
+        XSRETURN_UNDEF;
+    sc = (const sph_jh_context *)&state->u;
+#if SPH_64
+    RETVAL = newSVnv((NV)sc->block_count * 64 + sc->ptr);
+#else
+    RETVAL = newSVnv(((NV)sc->block_count_high * 4294967296.0
+        + sc->block_count_low) * 64 + sc->ptr);
+#endif
+OUTPUT:
+    RETVAL
+
+Digest::JH
+thaw (class, frozen)
+    SV *class
+    SV *frozen
+PREINIT:
+    jh_object obj;
+    unsigned char *data;
+    STRLEN len;
+CODE:
+    data = (unsigned char *)(SvPV(frozen, len));
+    if (! thaw_state(&obj.state, data, len))
+        XSRETURN_UNDEF;
+    obj.pending_init = 0;
+    Newx(RETVAL, 1, jh_object);
+    JH_STAT_ADD(JH_STAT_CTX_ALLOC, 1);
+    Copy(&obj, RETVAL, 1, jh_object);
+    JH_PROBE2(context_create, RETVAL, RETVAL->state.hashbitlen);
+OUTPUT:
+    RETVAL
+
 void
 DESTROY (self)
     Digest::JH self
 CODE:
+    JH_STAT_ADD(JH_STAT_CTX_FREE, 1);
+    JH_PROBE1(context_destroy, self);
     Safefree(self);
+
+MODULE = Digest::JH    PACKAGE = Digest::JH::HMAC
+
+void
+hmac_jh_224 (data, key)
+    SV *data
+    SV *key
+ALIAS:
+    hmac_jh_224 = 0
+    hmac_jh_224_hex = 1
+    hmac_jh_224_base64 = 2
+    hmac_jh_256 = 3
+    hmac_jh_256_hex = 4
+    hmac_jh_256_base64 = 5
+    hmac_jh_384 = 6
+    hmac_jh_384_hex = 7
+    hmac_jh_384_base64 = 8
+    hmac_jh_512 = 9
+    hmac_jh_512_hex = 10
+    hmac_jh_512_base64 = 11
+PREINIT:
+    jh_hmac_context hc;
+    int bitlen;
+    unsigned char *msg, *k;
+    STRLEN len, klen;
+    unsigned char result[64];
+CODE:
+    static const int ix2bits[] =
+        {224, 224, 224, 256, 256, 256, 384, 384, 384, 512, 512, 512};
+    bitlen = ix2bits[ix];
+    k = (unsigned char *)(SvPV(key, klen));
+    msg = (unsigned char *)(SvPV(data, len));
+    jh_hmac_init(&hc, bitlen, k, klen);
+    jh_hmac_mac(&hc, msg, len, result);
+    ST(0) = make_mortal_sv(aTHX_ result, bitlen, ix % 3);
+    XSRETURN(1);
+
+Digest::JH::HMAC
+new (class, key, hashsize)
+    SV *class
+    SV *key
+    int hashsize
+PREINIT:
+    unsigned char *k;
+    STRLEN klen;
+CODE:
+    if (! valid_hashbitlen(hashsize))
+        XSRETURN_UNDEF;
+    k = (unsigned char *)(SvPV(key, klen));
+    Newx(RETVAL, 1, jh_hmac_context);
+    jh_hmac_init(RETVAL, hashsize, k, klen);
+OUTPUT:
+    RETVAL
+
+Digest::JH::HMAC
+clone (self)
+    Digest::JH::HMAC self
+CODE:
+    Newx(RETVAL, 1, jh_hmac_context);
+    Copy(self, RETVAL, 1, jh_hmac_context);
+OUTPUT:
+    RETVAL
+
+void
+reset (self)
+    Digest::JH::HMAC self
+PPCODE:
+    jh_hmac_reset(self);
+    XSRETURN(1);
+
+int
+hashsize (self)
+    Digest::JH::HMAC self
+ALIAS:
+    algorithm = 1
+CODE:
+    RETVAL = self->out_size;
+OUTPUT:
+    RETVAL
+
+void
+add (self, ...)
+    Digest::JH::HMAC self
+PREINIT:
+    int i;
+    unsigned char *data;
+    STRLEN len;
+PPCODE:
+    for (i = 1; i < items; i++) {
+        data = (unsigned char *)(SvPV(ST(i), len));
+        jh_hmac_update(self, data, len);
+    }
+    XSRETURN(1);
+
+void *
+digest (self)
+    Digest::JH::HMAC self
+ALIAS:
+    digest = 0
+    hexdigest = 1
+    b64digest = 2
+    base64_padded_digest = 3
+PREINIT:
+    unsigned char result[64];
+CODE:
+    jh_hmac_close(self, result);
+    ST(0) = make_mortal_sv(aTHX_ result, self->out_size, ix);
+    XSRETURN(1);
+
+void
+digest_many (self, messages)
+    Digest::JH::HMAC self
+    AV *messages
+ALIAS:
+    digest_many = 0
+    hexdigest_many = 1
+    b64digest_many = 2
+PREINIT:
+    jh_hmac_batch batch;
+    const jh_hmac_context **keys;
+    const void **data;
+    size_t *lens;
+    unsigned char *out;
+    SSize_t i, n;
+    SV **svp;
+    STRLEN len;
+    int bytes;
+PPCODE:
+    n = av_len(messages) + 1;
+    if (! n)
+        XSRETURN_EMPTY;
+    bytes = self->out_size >> 3;
+    Newx(keys, n, const jh_hmac_context *);
+    SAVEFREEPV(keys);
+    Newx(data, n, const void *);
+    SAVEFREEPV(data);
+    Newx(lens, n, size_t);
+    SAVEFREEPV(lens);
+    Newx(out, n * bytes, unsigned char);
+    SAVEFREEPV(out);
+    for (i = 0; i < n; i++) {
+        svp = av_fetch(messages, i, 0);
+        if (svp)
+            data[i] = SvPV(*svp, len);
+        else {
+            data[i] = "";
+            len = 0;
+        }
+        lens[i] = len;
+        keys[i] = self;
+    }
+    if (jh_hmac_batch_init(&batch, n) < 0)
+        croak("Out of memory");
+    jh_hmac_batch_mac(&batch, keys, data, lens, n, out);
+    jh_hmac_batch_free(&batch);
+    EXTEND(SP, n);
+    for (i = 0; i < n; i++)
+        PUSHs(make_mortal_sv(aTHX_ out + i * bytes, self->out_size, ix));
+
+void
+DESTROY (self)
+    Digest::JH::HMAC self
+CODE:
+    Safefree(self);
+
+MODULE = Digest::JH    PACKAGE = Digest::JH::PrefixCache
+
+Digest::JH::PrefixCache
+new (class, hashsize, capacity = 64)
+    SV *class
+    int hashsize
+    UV capacity
+CODE:
+    if (! valid_hashbitlen(hashsize) || (items > 2 && SvNV(ST(2)) < 0)
+        || capacity > JH_PREFIX_MAX_CAPACITY)
+        XSRETURN_UNDEF;
+    RETVAL = jh_prefix_cache_new(hashsize, capacity);
+    if (! RETVAL)
+        XSRETURN_UNDEF;
+OUTPUT:
+    RETVAL
+
+void *
+digest (self, prefix, ...)
+    Digest::JH::PrefixCache self
+    SV *prefix
+ALIAS:
+    digest = 0
+    hexdigest = 1
+    b64digest = 2
+PREINIT:
+    const sph_jh_context *cached;
+    sph_jh_context sc;
+    int i;
+    unsigned char *data;
+    STRLEN len;
+    unsigned char result[64];
+CODE:
+    data = (unsigned char *)(SvPV(prefix, len));
+    cached = jh_prefix_cache_get(self, data, len);
+    if (! cached)
+        XSRETURN_UNDEF;
+    sc = *cached;
+    for (i = 2; i < items; i++) {
+        data = (unsigned char *)(SvPV(ST(i), len));
+        sph_jh(&sc, data, len);
+    }
+    sph_jh_close_size(&sc, result, jh_prefix_cache_out_size(self));
+    ST(0) = make_mortal_sv(aTHX_ result, jh_prefix_cache_out_size(self), ix);
+    XSRETURN(1);
+
+Digest::JH
+context (self, prefix)
+    Digest::JH::PrefixCache self
+    SV *prefix
+PREINIT:
+    const sph_jh_context *cached;
+    unsigned char *data;
+    STRLEN len;
+CODE:
+    data = (unsigned char *)(SvPV(prefix, len));
+    cached = jh_prefix_cache_get(self, data, len);
+    if (! cached)
+        XSRETURN_UNDEF;
+    Newx(RETVAL, 1, jh_object);
+    JH_STAT_ADD(JH_STAT_CTX_ALLOC, 1);
+    RETVAL->state.u.ctx512 = *cached;
+    RETVAL->state.hashbitlen = jh_prefix_cache_out_size(self);
+    RETVAL->state.output_computed = 0;
+    RETVAL->pending_init = 0;
+    JH_PROBE2(context_create, RETVAL, RETVAL->state.hashbitlen);
+OUTPUT:
+    RETVAL
+
+int
+hashsize (self)
+    Digest::JH::PrefixCache self
+ALIAS:
+    algorithm = 1
+CODE:
+    RETVAL = jh_prefix_cache_out_size(self);
+OUTPUT:
+    RETVAL
+
+UV
+count (self)
+    Digest::JH::PrefixCache self
+ALIAS:
+    count = 0
+    hits = 1
+    misses = 2
+CODE:
+    switch (ix) {
+    case 0:
+        RETVAL = jh_prefix_cache_count(self);
+        break;
+    case 1:
+        RETVAL = jh_prefix_cache_hits(self);
+        break;
+    default:
+        RETVAL = jh_prefix_cache_misses(self);
+        break;
+    }
+OUTPUT:
+    RETVAL
+
+void
+clear (self)
+    Digest::JH::PrefixCache self
+PPCODE:
+    jh_prefix_cache_clear(self);
+    XSRETURN(1);
+
+void
+DESTROY (self)
+    Digest::JH::PrefixCache self
+CODE:
+    jh_prefix_cache_free(self);
+
+MODULE = Digest::JH    PACKAGE = Digest::JH::Fixed
+
+Digest::JH::Fixed
+new (class, length, hashsize = 512)
+    SV *class
+    UV length
+    int hashsize
+CODE:
+    if (! valid_hashbitlen(hashsize))
+        XSRETURN_UNDEF;
+    Newx(RETVAL, 1, sph_jh_fixed);
+    sph_jh_fixed_init(RETVAL, length, hashsize);
+OUTPUT:
+    RETVAL
+
+void *
+digest (self, data)
+    Digest::JH::Fixed self
+    SV *data
+ALIAS:
+    digest = 0
+    hexdigest = 1
+    b64digest = 2
+PREINIT:
+    const char *d;
+    STRLEN len;
+    unsigned char result[64];
+CODE:
+    d = SvPV(data, len);
+    if (len != self->len)
+        XSRETURN_UNDEF;
+    sph_jh_fixed_hash(self, d, result);
+    ST(0) = make_mortal_sv(aTHX_ result, self->out_size, ix);
+    XSRETURN(1);
+
+void
+digest_many (self, messages)
+    Digest::JH::Fixed self
+    AV *messages
+ALIAS:
+    digest_many = 0
+    hexdigest_many = 1
+    b64digest_many = 2
+PREINIT:
+    const void **data;
+    unsigned char *out;
+    char *ok;
+    SSize_t i, j, n;
+    SV **svp;
+    STRLEN len;
+    int bytes;
+PPCODE:
+    n = av_len(messages) + 1;
+    if (! n)
+        XSRETURN_EMPTY;
+    bytes = self->out_size >> 3;
+    Newx(data, n, const void *);
+    SAVEFREEPV(data);
+    Newx(ok, n, char);
+    SAVEFREEPV(ok);
+    Newx(out, n * bytes, unsigned char);
+    SAVEFREEPV(out);
+    /* Messages of the wrong length get undef and are left out. */
+    for (i = j = 0; i < n; i++) {
+        svp = av_fetch(messages, i, 0);
+        ok[i] = 0;
+        if (svp) {
+            data[j] = SvPV(*svp, len);
+            if (len == self->len) {
+                ok[i] = 1;
+                j++;
+            }
+        }
+    }
+    sph_jh_fixed_many(self, data, j, out);
+    EXTEND(SP, n);
+    for (i = j = 0; i < n; i++) {
+        if (ok[i])
+            PUSHs(make_mortal_sv(aTHX_ out + j++ * bytes, self->out_size,
+                ix));
+        else
+            PUSHs(&PL_sv_undef);
+    }
+
+UV
+length (self)
+    Digest::JH::Fixed self
+CODE:
+    RETVAL = self->len;
+OUTPUT:
+    RETVAL
+
+int
+hashsize (self)
+    Digest::JH::Fixed self
+ALIAS:
+    algorithm = 1
+CODE:
+    RETVAL = self->out_size;
+OUTPUT:
+    RETVAL
+
+void
+DESTROY (self)
+    Digest::JH::Fixed self
+CODE:
+    Safefree(self);
+
+MODULE = Digest::JH    PACKAGE = Digest::JH::MerkleLog
+
+Digest::JH::MerkleLog
+_new (class, hashsize, store_nodes)
+    SV *class
+    int hashsize
+    int store_nodes
+CODE:
+    RETVAL = jh_merkle_new(hashsize, store_nodes);
+    if (! RETVAL)
+        XSRETURN_UNDEF;
+OUTPUT:
+    RETVAL
+
+Digest::JH::MerkleLog
+_open (class, hashsize, path)
+    SV *class
+    int hashsize
+    const char *path
+CODE:
+    RETVAL = jh_merkle_open(hashsize, path);
+    if (! RETVAL)
+        XSRETURN_UNDEF;
+OUTPUT:
+    RETVAL
+
+SV *
+append (self, ...)
+    Digest::JH::MerkleLog self
+PREINIT:
+    const void **data;
+    size_t *lens;
+    SSize_t i, n;
+    STRLEN len;
+CODE:
+    n = items - 1;
+    Newx(data, n + 1, const void *);
+    SAVEFREEPV(data);
+    Newx(lens, n + 1, size_t);
+    SAVEFREEPV(lens);
+    for (i = 0; i < n; i++) {
+        data[i] = SvPV(ST(i + 1), len);
+        lens[i] = len;
+    }
+    if (jh_merkle_append(self, data, lens, n) < 0)
+        XSRETURN_UNDEF;
+    RETVAL = newSVuv(jh_merkle_size(self));
+OUTPUT:
+    RETVAL
+
+UV
+size (self)
+    Digest::JH::MerkleLog self
+CODE:
+    RETVAL = jh_merkle_size(self);
+OUTPUT:
+    RETVAL
+
+int
+hashsize (self)
+    Digest::JH::MerkleLog self
+ALIAS:
+    algorithm = 1
+CODE:
+    RETVAL = jh_merkle_out_size(self);
+OUTPUT:
+    RETVAL
+
+void *
+root (self, size = NULL)
+    Digest::JH::MerkleLog self
+    SV *size
+ALIAS:
+    root = 0
+    hexroot = 1
+    b64root = 2
+PREINIT:
+    unsigned char result[64];
+CODE:
+    if (jh_merkle_root(self, size ? SvUV(size) : jh_merkle_size(self),
+            result) < 0)
+        XSRETURN_UNDEF;
+    ST(0) = make_mortal_sv(aTHX_ result, jh_merkle_out_size(self), ix);
+    XSRETURN(1);
+
+void *
+leaf_hash (self, index)
+    Digest::JH::MerkleLog self
+    UV index
+PREINIT:
+    unsigned char result[64];
+CODE:
+    if (jh_merkle_leaf(self, index, result) < 0)
+        XSRETURN_UNDEF;
+    ST(0) = make_mortal_sv(aTHX_ result, jh_merkle_out_size(self), 0);
+    XSRETURN(1);
+
+SV *
+inclusion_proof (self, index, size = NULL)
+    Digest::JH::MerkleLog self
+    UV index
+    SV *size
+ALIAS:
+    inclusion_proof = 0
+    consistency_proof = 1
+PREINIT:
+    unsigned char proof[JH_MERKLE_MAX_PROOF * 64];
+    UV tree_size;
+    AV *av;
+    int i, n, bytes;
+CODE:
+    tree_size = size ? SvUV(size) : jh_merkle_size(self);
+    n = ix ? jh_merkle_consistency(self, index, tree_size, proof)
+        : jh_merkle_inclusion(self, index, tree_size, proof);
+    if (n < 0)
+        XSRETURN_UNDEF;
+    bytes = jh_merkle_out_size(self) >> 3;
+    av = newAV();
+    for (i = 0; i < n; i++)
+        av_push(av, newSVpvn((char *)proof + i * bytes, bytes));
+    RETVAL = newRV_noinc((SV *)av);
+OUTPUT:
+    RETVAL
+
+int
+sync (self)
+    Digest::JH::MerkleLog self
+CODE:
+    RETVAL = jh_merkle_sync(self) == 0;
+OUTPUT:
+    RETVAL
+
+void
+DESTROY (self)
+    Digest::JH::MerkleLog self
+CODE:
+    jh_merkle_free(self);
+
+MODULE = Digest::JH    PACKAGE = Digest::JH::DRBG
+
+Digest::JH::DRBG
+new (class, entropy, nonce = NULL, personalization = NULL)
+    SV *class
+    SV *entropy
+    SV *nonce
+    SV *personalization
+PREINIT:
+    const char *e, *n = "", *p = "";
+    STRLEN elen, nlen = 0, plen = 0;
+CODE:
+    e = SvPV(entropy, elen);
+    if (nonce)
+        n = SvPV(nonce, nlen);
+    if (personalization)
+        p = SvPV(personalization, plen);
+    Newx(RETVAL, 1, jh_drbg);
+    jh_drbg_instantiate(RETVAL, e, elen, n, nlen, p, plen);
+OUTPUT:
+    RETVAL
+
+void
+reseed (self, entropy, additional = NULL)
+    Digest::JH::DRBG self
+    SV *entropy
+    SV *additional
+PREINIT:
+    const char *e, *a = "";
+    STRLEN elen, alen = 0;
+PPCODE:
+    e = SvPV(entropy, elen);
+    if (additional)
+        a = SvPV(additional, alen);
+    jh_drbg_reseed(self, e, elen, a, alen);
+    XSRETURN(1);
+
+SV *
+generate (self, length, additional = NULL)
+    Digest::JH::DRBG self
+    UV length
+    SV *additional
+PREINIT:
+    const char *a = "";
+    STRLEN alen = 0;
+CODE:
+    if (additional)
+        a = SvPV(additional, alen);
+    if (length > JH_DRBG_MAX_REQUEST)
+        XSRETURN_UNDEF;
+    RETVAL = newSV(length + 1);
+    if (jh_drbg_generate(self, SvPVX(RETVAL), length, a, alen) < 0) {
+        SvREFCNT_dec(RETVAL);
+        XSRETURN_UNDEF;
+    }
+    SvCUR_set(RETVAL, length);
+    SvPOK_only(RETVAL);
+OUTPUT:
+    RETVAL
+
+SV *
+bytes (self, length)
+    Digest::JH::DRBG self
+    UV length
+CODE:
+    RETVAL = newSV(length + 1);
+    if (jh_drbg_read(self, SvPVX(RETVAL), length) < 0) {
+        SvREFCNT_dec(RETVAL);
+        XSRETURN_UNDEF;
+    }
+    SvCUR_set(RETVAL, length);
+    SvPOK_only(RETVAL);
+OUTPUT:
+    RETVAL
+
+void
+DESTROY (self)
+    Digest::JH::DRBG self
+CODE:
+    Zero(self, 1, jh_drbg);
+    Safefree(self);
+
+
+MODULE = Digest::JH    PACKAGE = Digest::JH::Delta
+
+SV *
+_signature (fh, block_size, strong_len)
+    PerlIO *fh
+    UV block_size
+    unsigned strong_len
+PREINIT:
+    unsigned char *sig;
+    long n;
+CODE:
+    n = jh_delta_signature(perlio_reader, fh, block_size, strong_len, &sig);
+    if (n < 0)
+        XSRETURN_UNDEF;
+    RETVAL = newSVpvn((char *)sig, n);
+    free(sig);
+OUTPUT:
+    RETVAL
+
+SV *
+_delta (fh, signature)
+    PerlIO *fh
+    SV *signature
+PREINIT:
+    const char *sig;
+    STRLEN sig_len;
+    unsigned char *delta;
+    long n;
+CODE:
+    sig = SvPVbyte(signature, sig_len);
+    n = jh_delta_encode(perlio_reader, fh, (const unsigned char *)sig,
+        sig_len, &delta);
+    if (n == JH_DELTA_BAD_SIGNATURE)
+        croak("Invalid signature");
+    if (n < 0)
+        XSRETURN_UNDEF;
+    RETVAL = newSVpvn((char *)delta, n);
+    free(delta);
+OUTPUT:
+    RETVAL
@@ -0,0 +1,224 @@
+#!/usr/bin/env perl
+use strict;
+use warnings;
+
+use File::Temp qw(tempfile);
+use Getopt::Long qw(GetOptions :config no_ignore_case);
+use List::Util qw(max);
+use Time::HiRes qw(time);
+
+use Digest::JH qw(jh_256 jh_256_hex jh_256_base64);
+use Digest::JH::Fixed ();
+
+# Measures each way of computing JH-256 digests from Perl, by message size
+# and, for the batch interfaces, by batch size. The time per message is
+# split into the compression function, estimated as the number of 64-byte
+# blocks times the cost of one block, and the rest, which is the cost of
+# the binding: argument handling, context setup, buffering, output
+# encoding and the Perl calls themselves. For the batch interfaces, which
+# hash several messages at a time in vector lanes, the cost of a block is
+# measured separately for each batch size, as the slope of the time of
+# Digest::JH::Fixed between short and long messages at that batch size.
+
+my %opts = (
+    sizes   => '0,16,64,256,1K,4K,64K,1M',
+    batches => '1,4,16,64,256',
+    time    => 0.2,
+    samples => 5,
+    format  => 'table',
+);
+GetOptions(\%opts, 'sizes|s=s', 'batches|b=s', 'time|t=f', 'samples|n=i',
+    'paths|p=s', 'format|f=s', 'help|h')
+    or die "usage: $0 [options]; see --help\n";
+if ($opts{help}) {
+    print <<'USAGE';
+usage: api_benchmark.pl [options]
+  -s, --sizes LIST     message sizes in bytes, with K and M suffixes
+  -b, --batches LIST   batch sizes for the batch interfaces
+  -p, --paths LIST     only these paths (see the list in the output)
+  -t, --time SECONDS   minimum duration of a sample (default 0.2)
+  -n, --samples N      samples per measurement; the median is kept
+  -f, --format FMT     table, csv or json
+USAGE
+    exit;
+}
+
+sub parse_sizes {
+    return map {
+        /\A(\d+)([KkMm]?)\z/ or die "bad size: $_\n";
+        $1 * (lc $2 eq 'k' ? 1024 : lc $2 eq 'm' ? 1 << 20 : 1);
+    } split /,/, shift;
+}
+
+my @sizes   = parse_sizes($opts{sizes});
+my @batches = parse_sizes($opts{batches});
+
+# Returns the median time of one call of $code, in seconds.
+sub time_call {
+    my ($code) = @_;
+    my ($iters, $t) = (1);
+    while (1) {
+        $t = time;
+        $code->() for 1 .. $iters;
+        $t = time - $t;
+        last if $t >= $opts{time} / 10;
+        $iters *= 10;
+    }
+    $iters = int($iters * $opts{time} / $t) || 1;
+    my @samples;
+    for (1 .. $opts{samples}) {
+        $t = time;
+        $code->() for 1 .. $iters;
+        push @samples, (time - $t) / $iters;
+    }
+    @samples = sort { $a <=> $b } @samples;
+    return $samples[ $#samples / 2 ];
+}
+
+sub blocks { my $n = shift; return int($n / 64) + ($n % 64 ? 2 : 1) }
+
+# Cost of one compression: the slope of the time of jh_256 between an
+# empty message and a long one, where the call overhead is negligible.
+my $long = 'x' x (1 << 18);
+my $per_block = (
+    time_call(sub { jh_256($long) }) - time_call(sub { jh_256('') })
+) / (blocks(length $long) - blocks(0));
+
+# Cost of one compression in the vector lanes, per message, for batches
+# of $batch messages: the slope of the time of Fixed->digest_many between
+# short messages and long ones. Batches that do not fill the lanes cost
+# more per message than full ones.
+my %lane_block;
+sub lane_block_cost {
+    my ($batch) = @_;
+    return $lane_block{$batch} ||= do {
+        my ($short, $long) = (64, 16384);
+        my @short = ('x' x $short) x $batch;
+        my @long  = ('x' x $long) x $batch;
+        my $fs = Digest::JH::Fixed->new($short, 256);
+        my $fl = Digest::JH::Fixed->new($long, 256);
+        (
+            time_call(sub { $fl->digest_many(\@long) })
+            - time_call(sub { $fs->digest_many(\@short) })
+        ) / ($batch * (blocks($long) - blocks($short)));
+    };
+}
+
+# Each path returns a sub hashing $batch messages of $size bytes.
+my %paths = (
+    functional => sub {
+        my ($data) = @_;
+        sub { jh_256($_) for @$data };
+    },
+    hex => sub {
+        my ($data) = @_;
+        sub { jh_256_hex($_) for @$data };
+    },
+    base64 => sub {
+        my ($data) = @_;
+        sub { jh_256_base64($_) for @$data };
+    },
+    oo => sub {
+        my ($data) = @_;
+        sub { Digest::JH->new(256)->add($_)->digest for @$data };
+    },
+    oo_reuse => sub {
+        my ($data) = @_;
+        my $ctx = Digest::JH->new(256);
+        sub { $ctx->add($_)->digest for @$data };
+    },
+    clone => sub {
+        my ($data) = @_;
+        my $base = Digest::JH->new(256);
+        sub { $base->clone->add($_)->digest for @$data };
+    },
+    addfile => sub {
+        my ($data) = @_;
+        my ($fh, $file) = tempfile(UNLINK => 1);
+        binmode $fh;
+        print {$fh} $data->[0];
+        close $fh;
+        open $fh, '<', $file or die "Can't open $file: $!";
+        binmode $fh;
+        sub {
+            for (@$data) {
+                seek $fh, 0, 0;
+                Digest::JH->new(256)->addfile($fh)->digest;
+            }
+        };
+    },
+    suffixes => sub {
+        my ($data) = @_;
+        my $ctx = Digest::JH->new(256);
+        sub { $ctx->digest_suffixes($data) };
+    },
+    fixed_many => sub {
+        my ($data) = @_;
+        my $fixed = Digest::JH::Fixed->new(length $data->[0], 256);
+        sub { $fixed->digest_many($data) };
+    },
+);
+my %batch_path = (suffixes => 1, fixed_many => 1);
+my @order = qw(functional hex base64 oo oo_reuse clone addfile suffixes
+    fixed_many);
+@order = grep { my $p = $_; grep { $_ eq $p } split /,/, $opts{paths} }
+    @order if $opts{paths};
+
+my @results;
+for my $path (@order) {
+    for my $size (@sizes) {
+        for my $batch ($batch_path{$path} ? @batches : 1) {
+            # different messages, so nothing is cached along the way
+            my @data = map {
+                my $n = $_;
+                substr(pack('N*', map { $_ * 2654435761 + $n } 1 ..
+                    $size / 4 + 1), 0, $size);
+            } 1 .. $batch;
+            my $t = time_call($paths{$path}->(\@data)) / $batch;
+            my $kernel = blocks($size) * ($batch_path{$path}
+                ? lane_block_cost($batch) : $per_block);
+            push @results, {
+                path        => $path,
+                size        => $size,
+                batch       => $batch,
+                calls       => 1 / $t,
+                us          => $t * 1e6,
+                kernel_us   => $kernel * 1e6,
+                overhead_us => ($t - $kernel) * 1e6,
+                mb_s        => $size / $t / 1e6,
+            };
+        }
+    }
+}
+
+my @fields = qw(path size batch calls us kernel_us overhead_us mb_s);
+if ($opts{format} eq 'csv') {
+    print join(',', @fields), "\n";
+    print join(',', @{$_}{@fields}), "\n" for @results;
+}
+elsif ($opts{format} eq 'json') {
+    printf qq({\n  "per_block_ns": %.2f,\n), $per_block * 1e9;
+    printf qq(  "lane_block_ns": {%s},\n  "results": [\n), join ', ',
+        map { sprintf '"%d": %.2f', $_, $lane_block{$_} * 1e9 }
+        sort { $a <=> $b } keys %lane_block;
+    print join(",\n", map {
+        my $r = $_;
+        '    {' . join(', ', map {
+            $_ eq 'path' ? qq("$_": "$r->{$_}") : qq("$_": $r->{$_})
+        } @fields) . '}';
+    } @results), "\n  ]\n}\n";
+}
+else {
+    printf "compression: %.1f ns per 64-byte block\n", $per_block * 1e9;
+    printf "  in lanes, batches of %d: %.1f ns per block and message\n",
+        $_, $lane_block{$_} * 1e9 for sort { $a <=> $b } keys %lane_block;
+    print "\n";
+    printf "%-11s %8s %6s %12s %10s %10s %10s %9s %9s\n", 'path', 'bytes',
+        'batch', 'msgs/s', 'us/msg', 'kernel', 'overhead', 'overhead%',
+        'MB/s';
+    for (@results) {
+        printf "%-11s %8d %6d %12.0f %10.2f %10.2f %10.2f %8.0f%% %9.1f\n",
+            @{$_}{qw(path size batch calls us kernel_us overhead_us)},
+            100 * $_->{overhead_us} / max($_->{us}, 1e-9), $_->{mb_s};
+    }
+}
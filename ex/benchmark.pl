@@ -36,11 +36,18 @@ use Digest::Whirlpool     ();
 
 my %opts = (
     iterations => -1,
-    size       => 1,  # kB
+    sizes      => '64,1K,64K',
 );
-GetOptions(\%opts, 'iterations|i=i', 'size|s=f',);
+GetOptions(\%opts, 'iterations|i=i', 'sizes|s=s',);
 
-my $data = '01234567' x (128 * $opts{size});
+# Message sizes in bytes, with K and M suffixes; see ex/api_benchmark.pl
+# for the cost of each Digest::JH interface.
+my @sizes = map {
+    /\A(\d+)([KkMm]?)\z/ or die "bad size: $_\n";
+    $1 * (lc $2 eq 'k' ? 1024 : lc $2 eq 'm' ? 1 << 20 : 1);
+} split /,/, $opts{sizes};
+
+my $data;
 
 my %digests = (
     blake_224    => sub { Digest::BLAKE::blake_224($data) },
@@ -125,29 +132,35 @@ my %digests = (
     whirlpool    => sub { Digest::Whirlpool->new->add($data)->digest },
 );
 
-my $times = timethese -1, \%digests, 'none';
+for my $size (@sizes) {
+    $data = join '', map { chr(($_ * 131 + ($_ >> 8)) & 255) } 1 .. $size;
 
-my @info;
-my ($max_name_len, $max_rate_len, $max_bw_len) = (0, 0, 0);
+    my $times = timethese $opts{iterations}, \%digests, 'none';
 
-while (my ($name, $info) = each %$times) {
-    my ($duration, $cycles) = @{$info}[ 1, 5 ];
-    my $rate = sprintf '%.0f', $cycles / $duration;
-    my $bw = $rate * $opts{size} / 1024;
-    $bw = sprintf int $bw ? '%.0f' : '%.2f', $bw;
+    my @info;
+    my ($max_name_len, $max_rate_len, $max_bw_len) = (0, 0, 0);
 
-    push @info, [$name, $rate, $bw];
+    while (my ($name, $info) = each %$times) {
+        my ($duration, $cycles) = @{$info}[ 1, 5 ];
+        my $rate = sprintf '%.0f', $cycles / $duration;
+        my $bw = $rate * $size / 1024 / 1024;
+        $bw = sprintf int $bw ? '%.0f' : '%.2f', $bw;
 
-    $max_name_len = max $max_name_len, length($name);
-    $max_rate_len = max $max_rate_len, length($rate);
-    $max_bw_len   = max $max_bw_len,   length($bw);
-}
+        push @info, [$name, $rate, $bw];
+
+        $max_name_len = max $max_name_len, length($name);
+        $max_rate_len = max $max_rate_len, length($rate);
+        $max_bw_len   = max $max_bw_len,   length($bw);
+    }
 
-for my $rec (sort { $b->[1] <=> $a->[1] } @info) {
-    my ($name, $rate, $bw) = @$rec;
+    print "\n" unless $size == $sizes[0];
+    print "$size bytes\n";
+    for my $rec (sort { $b->[1] <=> $a->[1] } @info) {
+        my ($name, $rate, $bw) = @$rec;
 
-    my $name_padding = $max_name_len - length($name);
+        my $name_padding = $max_name_len - length($name);
 
-    printf "%s%s %${max_rate_len}s/s  %${max_bw_len}s MB/s\n",
-        $name, ' 'x$name_padding, $rate, $bw;
+        printf "%s%s %${max_rate_len}s/s  %${max_bw_len}s MB/s\n",
+            $name, ' 'x$name_padding, $rate, $bw;
+    }
 }
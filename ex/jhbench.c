@@ -0,0 +1,982 @@
+/*
+ * Benchmark of the JH kernels in src/jh.c, without Perl: nanoseconds per
+ * message and cycles per byte by message size, for each kernel compiled
+ * into this build.
+ *
+ * Build with "make jhbench", or "make jhbench-all" for the variants
+ * with rolled rounds, 32-bit words and no SIMD. The kernels are:
+ *
+ *   unrolled64, rolled64,   one message at a time through
+ *   unrolled32, rolled32    sph_jh() (whichever the build has)
+ *   x2                      two messages side by side in 128-bit vectors
+ *   x4                      four messages in AVX2 registers
+ *
+ * Each measurement is a set of samples, after a warmup, of enough calls
+ * to last --min-time; the median and percentiles of the samples are
+ * reported. With --sweep, working sets sized for each cache level are
+ * hashed instead, by one context or by many interleaved ones. Cycles
+ * are time stamp counter ticks, which on current x86 processors count
+ * at the nominal frequency, not the actual one; --counters adds the
+ * core's own cycle, instruction, cache and branch miss counts.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sched.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+#include "jh.c"
+
+#if defined __x86_64__ || defined __i386__
+#define HAVE_TSC 1
+#define ticks()  __builtin_ia32_rdtsc()
+#else
+#define HAVE_TSC 0
+#define ticks()  0
+#endif
+
+#if SPH_SMALL_FOOTPRINT_JH
+#define BUILD_ROLLED  1
+#else
+#define BUILD_ROLLED  0
+#endif
+#if SPH_JH_64
+#define BUILD_64      1
+#else
+#define BUILD_64      0
+#endif
+
+#ifndef _SC_LEVEL1_DCACHE_SIZE
+#define _SC_LEVEL1_DCACHE_SIZE  (-1)
+#define _SC_LEVEL2_CACHE_SIZE   (-1)
+#define _SC_LEVEL3_CACHE_SIZE   (-1)
+#endif
+
+#define MAX_LANES    4
+#define STREAM_STEP  ((size_t)1 << 20)
+#define DRAM_MIN     ((size_t)64 << 20)
+#define DRAM_MAX     ((size_t)512 << 20)
+#define MAX_SIZES    64
+#define MAX_SAMPLES  1001
+
+typedef struct {
+    const char *name;
+    unsigned lanes;
+    int mask;          /* CPU features to hide while it runs */
+} kernel;
+
+enum {
+    EV_CYCLES, EV_INSTRUCTIONS, EV_L1D_MISSES, EV_LLC_MISSES,
+    EV_BRANCH_MISSES, EV_L1I_MISSES, NEVENTS
+};
+
+/* Statistics of the samples of a measurement, per unit of work. */
+typedef struct {
+    double ns_min, ns_med, ns_p90, ns_p99;
+    double cyc_med;
+    double ev[NEVENTS];   /* counter totals, or -1 if not counted */
+} timing;
+
+typedef struct {
+    const char *kernel;
+    size_t size;
+    unsigned lanes;
+    timing t;          /* per message */
+} result;
+
+/* Something to time: iters repetitions of the same work. */
+typedef void (*workload)(void *arg, unsigned long iters);
+
+static const char *const default_sizes =
+    "0,1,16,64,256,1K,4K,16K,64K,256K,1M,4M,16M";
+
+static unsigned char *msg[MAX_LANES];
+static unsigned char out[MAX_LANES * 64];
+static volatile unsigned char sink;
+
+static double
+now_ns (void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static const char *
+single_name (void) {
+    static const char *const names[2][2] = {
+        { "unrolled32", "unrolled64" }, { "rolled32", "rolled64" }
+    };
+    return names[BUILD_ROLLED][BUILD_64];
+}
+
+/* The kernels of this build that the CPU can run. */
+static unsigned
+list_kernels (kernel *k) {
+    unsigned n = 0;
+
+    k[n].name = single_name();
+    k[n].lanes = 1;
+    k[n++].mask = 0;
+#if SPH_JH_LANES
+    k[n].name = "x2";
+    k[n].lanes = 2;
+    k[n++].mask = JH_CPU_AVX2;
+#if JH_X86_DISPATCH
+    if (jh_cpu_features() & JH_CPU_AVX2) {
+        k[n].name = "x4";
+        k[n].lanes = 4;
+        k[n++].mask = 0;
+    }
+#endif
+#endif
+    return n;
+}
+
+/* Hashes one message per lane, iters times. */
+static void
+run (const kernel *k, size_t size, unsigned bits, unsigned long iters) {
+    sph_jh_context sc;
+    const sph_jh_context *starts[MAX_LANES];
+    const void *data[MAX_LANES];
+    size_t len[MAX_LANES];
+    unsigned i;
+
+    sph_jh_init_size(&sc, bits);
+    for (i = 0; i < k->lanes; i++) {
+        starts[i] = &sc;
+        data[i] = msg[i];
+        len[i] = size;
+    }
+    while (iters--) {
+        if (k->lanes == 1) {
+            sph_jh_context c = sc;
+            sph_jh(&c, msg[0], size);
+            sph_jh_close_size(&c, out, bits);
+        }
+        else
+            sph_jh_multi_close(starts, data, len, k->lanes, out, bits);
+        sink ^= out[0];
+    }
+}
+
+/* Checks every kernel against sph_jh() on sizes around block edges. */
+static int
+self_check (const kernel *k, unsigned nk, unsigned bits) {
+    static const size_t sizes[] = { 0, 1, 63, 64, 65, 127, 128, 1000 };
+    unsigned char want[MAX_LANES * 64];
+    sph_jh_context sc;
+    unsigned i, s, l, hlen = bits >> 3;
+    int saved = jh_cpu_features();
+
+    for (s = 0; s < sizeof sizes / sizeof *sizes; s++) {
+        for (l = 0; l < MAX_LANES; l++) {
+            sph_jh_init_size(&sc, bits);
+            sph_jh(&sc, msg[l], sizes[s]);
+            sph_jh_close_size(&sc, want + l * hlen, bits);
+        }
+        for (i = 0; i < nk; i++) {
+            jh_cpu_cache = saved & ~k[i].mask;
+            memset(out, 0, sizeof out);
+            run(&k[i], sizes[s], bits, 1);
+            jh_cpu_cache = saved;
+            if (memcmp(out, want, k[i].lanes * hlen)) {
+                fprintf(stderr, "jhbench: %s gives a wrong digest for "
+                    "%lu bytes\n", k[i].name, (unsigned long)sizes[s]);
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+static int
+cmp_double (const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+/* Nearest-rank percentile of sorted samples. */
+static double
+percentile (const double *v, unsigned n, double p) {
+    unsigned r = (unsigned)(p / 100 * n + 0.999999);
+    return v[r ? r - 1 : 0];
+}
+
+/*
+ * Hardware counters, with perf_event_open() on Linux: one event each,
+ * counting this thread in user mode, and scaled up if the kernel had
+ * to multiplex them. Where perf events are not allowed, as in many
+ * containers, none open and only the clocks are used.
+ */
+
+static const char *const event_names[NEVENTS] = {
+    "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses",
+    "l1i_misses"
+};
+static int event_fd[NEVENTS];
+static int counting;
+
+#ifdef __linux__
+
+#define CACHE_MISS(c) \
+    ((c) | (PERF_COUNT_HW_CACHE_OP_READ << 8) \
+        | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+static int
+counters_open (void) {
+    static const struct { unsigned type; unsigned long long config; }
+        events[NEVENTS] = {
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { PERF_TYPE_HW_CACHE, CACHE_MISS(PERF_COUNT_HW_CACHE_L1D) },
+        { PERF_TYPE_HW_CACHE, CACHE_MISS(PERF_COUNT_HW_CACHE_LL) },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+        { PERF_TYPE_HW_CACHE, CACHE_MISS(PERF_COUNT_HW_CACHE_L1I) }
+    };
+    struct perf_event_attr attr;
+    int i, n = 0;
+
+    for (i = 0; i < NEVENTS; i++) {
+        memset(&attr, 0, sizeof attr);
+        attr.size = sizeof attr;
+        attr.type = events[i].type;
+        attr.config = events[i].config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED
+            | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        event_fd[i] = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1,
+            0);
+        if (event_fd[i] >= 0)
+            n++;
+    }
+    return n;
+}
+
+static void
+counters_start (void) {
+    int i;
+
+    for (i = 0; i < NEVENTS; i++)
+        if (event_fd[i] >= 0) {
+            ioctl(event_fd[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(event_fd[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+}
+
+static void
+counters_stop (double *ev) {
+    unsigned long long v[3];   /* value, time enabled, time running */
+    int i;
+
+    for (i = 0; i < NEVENTS; i++) {
+        ev[i] = -1;
+        if (event_fd[i] < 0)
+            continue;
+        ioctl(event_fd[i], PERF_EVENT_IOC_DISABLE, 0);
+        if (read(event_fd[i], v, sizeof v) == sizeof v && v[2])
+            ev[i] = (double)v[0] * v[1] / v[2];
+    }
+}
+
+#else
+
+static int
+counters_open (void) {
+    int i;
+
+    for (i = 0; i < NEVENTS; i++)
+        event_fd[i] = -1;
+    return 0;
+}
+
+static void
+counters_start (void) {
+}
+
+static void
+counters_stop (double *ev) {
+    int i;
+
+    for (i = 0; i < NEVENTS; i++)
+        ev[i] = -1;
+}
+
+#endif
+
+/*
+ * Prints the counters of a measurement: instructions per cycle, then
+ * the events per compressed block.
+ */
+static void
+print_counters (int format, const timing *t, double blocks) {
+    double v;
+    int i;
+
+    if (! counting)
+        return;
+    v = t->ev[EV_CYCLES] > 0 && t->ev[EV_INSTRUCTIONS] >= 0
+        ? t->ev[EV_INSTRUCTIONS] / t->ev[EV_CYCLES] : -1;
+    for (i = -1; i < NEVENTS; i++) {
+        if (i == EV_INSTRUCTIONS)
+            continue;
+        if (i >= 0)
+            v = t->ev[i] >= 0 && blocks > 0 ? t->ev[i] / blocks : -1;
+        switch (format) {
+        case 'c':
+            if (v >= 0)
+                printf(",%.3f", v);
+            else
+                printf(",");
+            break;
+        case 'j':
+            printf(", \"%s%s\": ", i < 0 ? "ipc" : event_names[i],
+                i < 0 ? "" : "_per_block");
+            if (v >= 0)
+                printf("%.3f", v);
+            else
+                printf("null");
+            break;
+        default:
+            if (v >= 0)
+                printf(" %9.2f", v);
+            else
+                printf(" %9s", "-");
+        }
+    }
+}
+
+static void
+print_counter_header (int format) {
+    static const char *const short_names[NEVENTS] = {
+        "cyc/blk", "", "l1d/blk", "llc/blk", "br/blk", "l1i/blk"
+    };
+    int i;
+
+    if (! counting)
+        return;
+    for (i = -1; i < NEVENTS; i++) {
+        if (i == EV_INSTRUCTIONS)
+            continue;
+        if (format == 'c')
+            printf(",%s%s", i < 0 ? "ipc" : event_names[i],
+                i < 0 ? "" : "_per_block");
+        else if (format == 't')
+            printf(" %9s", i < 0 ? "ipc" : short_names[i]);
+    }
+}
+
+/* Compressions for a message of len bytes, with the padding. */
+static double
+blocks_of (size_t len) {
+    return (double)(len >> 6) + ((len & 63) ? 2 : 1);
+}
+
+/*
+ * Times a workload worth units per repetition: finds a repetition count
+ * that lasts min_ns, which also warms up, then takes the samples.
+ */
+static void
+time_workload (workload fn, void *arg, double units, unsigned samples,
+               double min_ns, timing *r) {
+    static double ns[MAX_SAMPLES], cyc[MAX_SAMPLES];
+    unsigned long iters = 1;
+    double t, per;
+    unsigned long long c;
+    unsigned i;
+
+    for (;;) {
+        t = now_ns();
+        fn(arg, iters);
+        t = now_ns() - t;
+        if (t >= min_ns || iters >= 1UL << 30)
+            break;
+        iters *= t * 16 < min_ns ? 16 : 2;
+    }
+    per = (double)iters * units;
+    if (counting)
+        counters_start();
+    for (i = 0; i < samples; i++) {
+        c = ticks();
+        t = now_ns();
+        fn(arg, iters);
+        t = now_ns() - t;
+        c = ticks() - c;
+        ns[i] = t / per;
+        cyc[i] = c / per;
+    }
+    if (counting) {
+        counters_stop(r->ev);
+        for (i = 0; i < NEVENTS; i++)
+            if (r->ev[i] >= 0)
+                r->ev[i] /= per * samples;
+    }
+    qsort(ns, samples, sizeof *ns, cmp_double);
+    qsort(cyc, samples, sizeof *cyc, cmp_double);
+    r->ns_min = ns[0];
+    r->ns_med = percentile(ns, samples, 50);
+    r->ns_p90 = percentile(ns, samples, 90);
+    r->ns_p99 = percentile(ns, samples, 99);
+    r->cyc_med = percentile(cyc, samples, 50);
+}
+
+typedef struct {
+    const kernel *k;
+    size_t size;
+    unsigned bits;
+} kernel_work;
+
+static void
+run_kernel (void *arg, unsigned long iters) {
+    const kernel_work *w = arg;
+    run(w->k, w->size, w->bits, iters);
+}
+
+static void
+measure (const kernel *k, size_t size, unsigned bits, unsigned samples,
+         double min_ns, result *r) {
+    kernel_work w;
+
+    w.k = k;
+    w.size = size;
+    w.bits = bits;
+    time_workload(run_kernel, &w, k->lanes, samples, min_ns, &r->t);
+    r->kernel = k->name;
+    r->size = size;
+    r->lanes = k->lanes;
+}
+
+static void
+warmup (const kernel *k, unsigned bits, double ms) {
+    double end = now_ns() + ms * 1e6;
+    while (now_ns() < end)
+        run(k, 4096, bits, 16);
+}
+
+static int
+parse_size (const char *s, size_t *v) {
+    char *end;
+    unsigned long n = strtoul(s, &end, 10);
+
+    if (end == s)
+        return -1;
+    if (*end == 'K' || *end == 'k')
+        n <<= 10, end++;
+    else if (*end == 'M' || *end == 'm')
+        n <<= 20, end++;
+    if (*end && *end != ',')
+        return -1;
+    *v = n;
+    return 0;
+}
+
+static unsigned
+parse_sizes (const char *s, size_t *sizes) {
+    unsigned n = 0;
+
+    while (*s && n < MAX_SIZES) {
+        if (parse_size(s, &sizes[n]) < 0)
+            return 0;
+        n++;
+        s = strchr(s, ',');
+        if (! s)
+            break;
+        s++;
+    }
+    return n;
+}
+
+static int
+pin_cpu (int cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+
+    if (cpu < 0)
+        cpu = sched_getcpu();
+    if (cpu < 0)
+        return -1;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof set, &set) < 0)
+        return -1;
+    return cpu;
+#else
+    (void)cpu;
+    return -1;
+#endif
+}
+
+static void
+print_build (FILE *f, int json, int cpu, unsigned bits) {
+    const char *fmt = json
+        ? "  \"build\": {\"compiler\": \"%s\", \"jh_64\": %d, "
+          "\"small_footprint\": %d, \"lanes\": %d, \"x86_dispatch\": %d, "
+          "\"ssse3\": %d, \"avx2\": %d, \"tsc\": %d, \"cpu\": %d, "
+          "\"bits\": %u},\n"
+        : "# compiler %s, jh_64 %d, small_footprint %d, lanes %d, "
+          "x86_dispatch %d, ssse3 %d, avx2 %d, tsc %d, cpu %d, bits %u\n";
+    int f_ = jh_cpu_features();
+
+    fprintf(f, fmt,
+#ifdef __VERSION__
+        __VERSION__,
+#else
+        "unknown",
+#endif
+        BUILD_64, BUILD_ROLLED, SPH_JH_LANES,
+        JH_X86_DISPATCH, ! ! (f_ & JH_CPU_SSSE3), ! ! (f_ & JH_CPU_AVX2),
+        HAVE_TSC, cpu, bits);
+}
+
+static void
+print_result (int format, const result *r, int first) {
+    double cpb = r->size ? r->t.cyc_med / r->size : 0;
+    double mbs = r->t.ns_med > 0 ? r->size / r->t.ns_med * 1e3 : 0;
+
+    switch (format) {
+    case 'c':
+        printf("%s,%lu,%u,%.1f,%.1f,%.1f,%.1f,%.0f,", r->kernel,
+            (unsigned long)r->size, r->lanes, r->t.ns_min, r->t.ns_med,
+            r->t.ns_p90, r->t.ns_p99, HAVE_TSC ? r->t.cyc_med : 0);
+        if (HAVE_TSC && r->size)
+            printf("%.2f", cpb);
+        printf(",%.1f", mbs);
+        print_counters(format, &r->t, blocks_of(r->size));
+        printf("\n");
+        break;
+    case 'j':
+        printf("%s    {\"kernel\": \"%s\", \"size\": %lu, \"lanes\": %u, "
+            "\"ns_min\": %.1f, \"ns_median\": %.1f, \"ns_p90\": %.1f, "
+            "\"ns_p99\": %.1f, \"cycles_median\": ", first ? "" : ",\n",
+            r->kernel, (unsigned long)r->size, r->lanes, r->t.ns_min,
+            r->t.ns_med, r->t.ns_p90, r->t.ns_p99);
+        if (HAVE_TSC)
+            printf("%.0f", r->t.cyc_med);
+        else
+            printf("null");
+        printf(", \"cycles_per_byte\": ");
+        if (HAVE_TSC && r->size)
+            printf("%.2f", cpb);
+        else
+            printf("null");
+        printf(", \"mb_per_s\": %.1f", mbs);
+        print_counters(format, &r->t, blocks_of(r->size));
+        printf("}");
+        break;
+    default:
+        printf("%-11s %9lu %14.1f %14.1f %14.1f", r->kernel,
+            (unsigned long)r->size, r->t.ns_med, r->t.ns_p90, r->t.ns_p99);
+        if (HAVE_TSC && r->size)
+            printf(" %10.2f", cpb);
+        else
+            printf(" %10s", "-");
+        printf(" %10.1f", mbs);
+        print_counters(format, &r->t, blocks_of(r->size));
+        printf("\n");
+    }
+}
+
+/*
+ * Cache sweep: the same bytes hashed from working sets that fit in each
+ * cache level, as one long message and in chunks spread over many live
+ * contexts. The contexts take their turns round-robin, so with enough
+ * of them each turn finds its context evicted, as in a server that
+ * keeps many uploads open at once.
+ */
+
+/* One long message, fed step bytes at a time from the working set. */
+typedef struct {
+    sph_jh_context sc;
+    const unsigned char *buf;
+    size_t len, pos, step;
+} stream_work;
+
+static void
+run_stream (void *arg, unsigned long iters) {
+    stream_work *w = arg;
+
+    while (iters--) {
+        if (w->pos + w->step > w->len)
+            w->pos = 0;
+        sph_jh(&w->sc, w->buf + w->pos, w->step);
+        w->pos += w->step;
+    }
+    sink ^= ((unsigned char *)w->sc.buf)[0];
+}
+
+typedef struct {
+    sph_jh_context *sc;
+    size_t n, chunk;
+    const unsigned char *buf;
+    size_t len, pos;
+} interleave_work;
+
+static void
+run_interleaved (void *arg, unsigned long iters) {
+    interleave_work *w = arg;
+    size_t i;
+
+    while (iters--)
+        for (i = 0; i < w->n; i++) {
+            if (w->pos + w->chunk > w->len)
+                w->pos = 0;
+            sph_jh(&w->sc[i], w->buf + w->pos, w->chunk);
+            w->pos += w->chunk;
+        }
+    sink ^= ((unsigned char *)w->sc[0].buf)[0];
+}
+
+typedef struct {
+    const char *level;
+    size_t working_set;
+    const char *mode;
+    size_t contexts, chunk;
+    timing t;          /* per byte */
+} sweep_result;
+
+/* A cache size from sysconf(), where the C library knows it. */
+static size_t
+cache_size (int name, size_t fallback) {
+    long n = name < 0 ? -1 : sysconf(name);
+    return n > 0 ? (size_t)n : fallback;
+}
+
+static void
+print_sweep (int format, const sweep_result *r, int first) {
+    double block = r->t.ns_med * 64, mbs = 1e3 / r->t.ns_med;
+
+    switch (format) {
+    case 'c':
+        printf("%s,%lu,%s,%lu,%lu,%.1f,%.1f,%.2f,%.1f", r->level,
+            (unsigned long)r->working_set, r->mode,
+            (unsigned long)r->contexts, (unsigned long)r->chunk, block,
+            r->t.ns_p90 * 64, HAVE_TSC ? r->t.cyc_med : 0, mbs);
+        print_counters(format, &r->t, 1.0 / 64);
+        printf("\n");
+        break;
+    case 'j':
+        printf("%s    {\"level\": \"%s\", \"working_set\": %lu, "
+            "\"mode\": \"%s\", \"contexts\": %lu, \"chunk\": %lu, "
+            "\"ns_per_block_median\": %.1f, \"ns_per_block_p90\": %.1f, "
+            "\"cycles_per_byte\": ", first ? "" : ",\n", r->level,
+            (unsigned long)r->working_set, r->mode,
+            (unsigned long)r->contexts, (unsigned long)r->chunk, block,
+            r->t.ns_p90 * 64);
+        if (HAVE_TSC)
+            printf("%.2f", r->t.cyc_med);
+        else
+            printf("null");
+        printf(", \"mb_per_s\": %.1f", mbs);
+        print_counters(format, &r->t, 1.0 / 64);
+        printf("}");
+        break;
+    default:
+        printf("%-5s %10lu %-11s %8lu %6lu %12.1f %12.1f", r->level,
+            (unsigned long)r->working_set, r->mode,
+            (unsigned long)r->contexts, (unsigned long)r->chunk, block,
+            r->t.ns_p90 * 64);
+        if (HAVE_TSC)
+            printf(" %10.2f", r->t.cyc_med);
+        else
+            printf(" %10s", "-");
+        printf(" %10.1f", mbs);
+        print_counters(format, &r->t, 1.0 / 64);
+        printf("\n");
+    }
+}
+
+static int
+sweep (int format, unsigned bits, unsigned samples, double min_ns,
+       size_t contexts, size_t chunk) {
+    static const char *const levels[] = { "L1", "L2", "L3", "DRAM" };
+    size_t ws[4], i, c;
+    unsigned l;
+    unsigned char *buf;
+    sph_jh_context *sc, init;
+    stream_work sw;
+    interleave_work iw;
+    sweep_result r;
+    int first = 1;
+
+    /* half of each cache, to leave room for everything else */
+    ws[0] = cache_size(_SC_LEVEL1_DCACHE_SIZE, 32 << 10) / 2;
+    ws[1] = cache_size(_SC_LEVEL2_CACHE_SIZE, 1 << 20) / 2;
+    ws[2] = cache_size(_SC_LEVEL3_CACHE_SIZE, 8 << 20) / 2;
+    ws[3] = ws[2] * 8 < DRAM_MIN ? DRAM_MIN
+        : ws[2] * 8 > DRAM_MAX ? DRAM_MAX : ws[2] * 8;
+    if (chunk > ws[0])
+        chunk = ws[0];
+
+    buf = malloc(ws[3]);
+    sc = malloc(contexts * sizeof *sc);
+    if (! buf || ! sc) {
+        fprintf(stderr, "jhbench: %s\n", strerror(ENOMEM));
+        free(buf);
+        free(sc);
+        return -1;
+    }
+    for (i = 0; i < ws[3]; i++)
+        buf[i] = (unsigned char)(i * 131 + (i >> 8));
+    sph_jh_init_size(&init, bits);
+
+    for (l = 0; l < 4; l++) {
+        r.level = levels[l];
+        r.working_set = ws[l];
+
+        sw.sc = init;
+        sw.buf = buf;
+        sw.len = ws[l];
+        sw.pos = 0;
+        sw.step = ws[l] < STREAM_STEP ? ws[l] : STREAM_STEP;
+        time_workload(run_stream, &sw, sw.step, samples, min_ns, &r.t);
+        r.mode = "stream";
+        r.contexts = 1;
+        r.chunk = sw.step;
+        print_sweep(format, &r, first);
+        first = 0;
+
+        /* one context in chunks, then all of them */
+        for (c = 1; c <= contexts; c = c < contexts ? contexts : c + 1) {
+            for (i = 0; i < c; i++)
+                sc[i] = init;
+            iw.sc = sc;
+            iw.n = c;
+            iw.chunk = chunk;
+            iw.buf = buf;
+            iw.len = ws[l];
+            iw.pos = 0;
+            time_workload(run_interleaved, &iw, (double)c * chunk, samples,
+                min_ns, &r.t);
+            r.mode = c == 1 ? "chunked" : "interleaved";
+            r.contexts = c;
+            r.chunk = chunk;
+            print_sweep(format, &r, 0);
+        }
+        fflush(stdout);
+    }
+    free(buf);
+    free(sc);
+    return 0;
+}
+
+static void
+usage (FILE *f) {
+    fprintf(f,
+"usage: jhbench [options]\n"
+"  -s, --sizes LIST     message sizes, with K and M suffixes\n"
+"                       (default %s)\n"
+"  -k, --kernel NAME    only this kernel (default: all of this build)\n"
+"  -b, --bits N         output size: 224, 256, 384 or 512 (default 256)\n"
+"  -n, --samples N      samples per measurement (default 21)\n"
+"  -t, --min-time MS    minimum duration of a sample (default 5)\n"
+"  -w, --warmup MS      warmup before each kernel (default 200)\n"
+"  -c, --cpu N          pin to this CPU; -1 for the current one (default),\n"
+"                       -2 to leave the thread unpinned\n"
+"  -f, --format FMT     table, csv or json (default table)\n"
+"  -l, --list           list the kernels and exit\n"
+"  -S, --sweep          cache sweep: hash working sets sized for L1, L2,\n"
+"                       L3 and DRAM with sph_jh(), as one stream, in\n"
+"                       chunks, and in chunks over many contexts\n"
+"  -C, --contexts N     live contexts for the sweep (default 10000)\n"
+"  -K, --chunk N        bytes per context per turn (default 1K)\n"
+"  -P, --counters       read hardware counters (Linux), and print IPC\n"
+"                       and cycles and misses per compressed block\n",
+        default_sizes);
+}
+
+int
+main (int argc, char **argv) {
+    static const struct option longopts[] = {
+        { "sizes", required_argument, NULL, 's' },
+        { "kernel", required_argument, NULL, 'k' },
+        { "bits", required_argument, NULL, 'b' },
+        { "samples", required_argument, NULL, 'n' },
+        { "min-time", required_argument, NULL, 't' },
+        { "warmup", required_argument, NULL, 'w' },
+        { "cpu", required_argument, NULL, 'c' },
+        { "format", required_argument, NULL, 'f' },
+        { "list", no_argument, NULL, 'l' },
+        { "sweep", no_argument, NULL, 'S' },
+        { "contexts", required_argument, NULL, 'C' },
+        { "chunk", required_argument, NULL, 'K' },
+        { "counters", no_argument, NULL, 'P' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    kernel k[4];
+    result r;
+    size_t sizes[MAX_SIZES], max_size = 0, contexts = 10000, chunk = 1024;
+    const char *only = NULL;
+    unsigned nk, nsizes, bits = 256, samples = 21, i, j, l;
+    double min_ms = 5, warmup_ms = 200;
+    int cpu = -1, format = 't', opt, saved, first = 1, list = 0;
+    int do_sweep = 0;
+
+    nsizes = parse_sizes(default_sizes, sizes);
+    while ((opt = getopt_long(argc, argv, "s:k:b:n:t:w:c:f:lSC:K:Ph", longopts,
+            NULL)) != -1) {
+        switch (opt) {
+        case 's':
+            nsizes = parse_sizes(optarg, sizes);
+            if (! nsizes) {
+                fprintf(stderr, "jhbench: bad sizes: %s\n", optarg);
+                return 2;
+            }
+            break;
+        case 'k': only = optarg; break;
+        case 'b': bits = (unsigned)atoi(optarg); break;
+        case 'n': samples = (unsigned)atoi(optarg); break;
+        case 't': min_ms = atof(optarg); break;
+        case 'w': warmup_ms = atof(optarg); break;
+        case 'c': cpu = atoi(optarg); break;
+        case 'f':
+            format = optarg[0];
+            if (strcmp(optarg, "table") && strcmp(optarg, "csv")
+                && strcmp(optarg, "json")) {
+                usage(stderr);
+                return 2;
+            }
+            break;
+        case 'l': list = 1; break;
+        case 'S': do_sweep = 1; break;
+        case 'P': counting = 1; break;
+        case 'C': contexts = strtoul(optarg, NULL, 10); break;
+        case 'K':
+            if (parse_size(optarg, &chunk) < 0 || ! chunk) {
+                fprintf(stderr, "jhbench: bad chunk size: %s\n", optarg);
+                return 2;
+            }
+            break;
+        case 'h': usage(stdout); return 0;
+        default: usage(stderr); return 2;
+        }
+    }
+    if (bits != 224 && bits != 256 && bits != 384 && bits != 512) {
+        fprintf(stderr, "jhbench: bad output size: %u\n", bits);
+        return 2;
+    }
+    if (! contexts) {
+        fprintf(stderr, "jhbench: contexts must be at least 1\n");
+        return 2;
+    }
+    if (! samples || samples > MAX_SAMPLES) {
+        fprintf(stderr, "jhbench: samples must be 1 to %d\n", MAX_SAMPLES);
+        return 2;
+    }
+
+    nk = list_kernels(k);
+    if (list) {
+        for (i = 0; i < nk; i++)
+            printf("%s\n", k[i].name);
+        return 0;
+    }
+    if (only) {
+        for (i = 0; i < nk && strcmp(k[i].name, only); i++)
+            ;
+        if (i == nk) {
+            fprintf(stderr, "jhbench: no kernel %s in this build\n", only);
+            return 2;
+        }
+        k[0] = k[i];
+        nk = 1;
+    }
+
+    for (i = 0; i < nsizes; i++)
+        if (sizes[i] > max_size)
+            max_size = sizes[i];
+    for (l = 0; l < MAX_LANES; l++) {
+        msg[l] = malloc(max_size > 1000 ? max_size : 1000);
+        if (! msg[l]) {
+            fprintf(stderr, "jhbench: %s\n", strerror(ENOMEM));
+            return 1;
+        }
+        for (i = 0; i < (max_size > 1000 ? max_size : 1000); i++)
+            msg[l][i] = (unsigned char)(i * 131 + (i >> 8) + l);
+    }
+    if (self_check(k, nk, bits) < 0)
+        return 1;
+    if (counting && ! counters_open()) {
+        fprintf(stderr, "jhbench: warning: hardware counters are not "
+            "available, timing only\n");
+        counting = 0;
+    }
+    if (cpu != -2) {
+        cpu = pin_cpu(cpu);
+        if (cpu < 0)
+            fprintf(stderr, "jhbench: warning: could not pin to a CPU\n");
+    }
+
+    if (do_sweep) {
+        if (format == 'j') {
+            printf("{\n");
+            print_build(stdout, 1, cpu, bits);
+            printf("  \"results\": [\n");
+        }
+        else {
+            print_build(format == 'c' ? stderr : stdout, 0, cpu, bits);
+            if (format == 'c')
+                printf("level,working_set,mode,contexts,chunk,"
+                    "ns_per_block_median,ns_per_block_p90,cycles_per_byte,"
+                    "mb_per_s");
+            else
+                printf("%-5s %10s %-11s %8s %6s %12s %12s %10s %10s",
+                    "level", "bytes", "mode", "contexts", "chunk",
+                    "ns/blk (med)", "ns/blk (p90)", "cyc/byte", "MB/s");
+            print_counter_header(format);
+            printf("\n");
+        }
+        if (sweep(format, bits, samples, min_ms * 1e6, contexts, chunk) < 0)
+            return 1;
+        if (format == 'j')
+            printf("\n  ]\n}\n");
+        return 0;
+    }
+
+    if (format == 'j') {
+        printf("{\n");
+        print_build(stdout, 1, cpu, bits);
+        printf("  \"results\": [\n");
+    }
+    else {
+        print_build(format == 'c' ? stderr : stdout, 0, cpu, bits);
+        if (format == 'c')
+            printf("kernel,size,lanes,ns_min,ns_median,ns_p90,ns_p99,"
+                "cycles_median,cycles_per_byte,mb_per_s");
+        else
+            printf("%-11s %9s %14s %14s %14s %10s %10s", "kernel",
+                "bytes", "ns/msg (med)", "ns/msg (p90)", "ns/msg (p99)",
+                "cyc/byte", "MB/s");
+        print_counter_header(format);
+        printf("\n");
+    }
+
+    saved = jh_cpu_features();
+    for (i = 0; i < nk; i++) {
+        jh_cpu_cache = saved & ~k[i].mask;
+        warmup(&k[i], bits, warmup_ms);
+        for (j = 0; j < nsizes; j++) {
+            measure(&k[i], sizes[j], bits, samples, min_ms * 1e6, &r);
+            print_result(format, &r, first);
+            first = 0;
+            fflush(stdout);
+        }
+    }
+    jh_cpu_cache = saved;
+
+    if (format == 'j')
+        printf("\n  ]\n}\n");
+    for (l = 0; l < MAX_LANES; l++)
+        free(msg[l]);
+    return 0;
+}
@@ -0,0 +1,93 @@
+#!/usr/bin/env perl
+use strict;
+use warnings;
+
+use File::Temp qw(tempfile);
+
+use Digest::JH qw(
+    jh_224 jh_256 jh_384 jh_512 jh_256_hex jh_512_hex jh_256_base64
+    chain_many pieces
+);
+use Digest::JH::Fixed ();
+use Digest::JH::HMAC qw(hmac_jh_256);
+
+# Training workload for "make pgo": run against the instrumented build,
+# it records which branches and calls are hot, for the compiler to lay
+# out the optimized build. The mix follows typical use: mostly short
+# messages, through both the functional and the OO interfaces, with
+# many finalizations, a fair amount of long messages and streaming in
+# uneven pieces, and some of the batch interfaces. Every output size and
+# encoding is exercised so none of them is laid out as cold.
+
+my $rounds = shift || 20;
+
+my $seed = 1;
+sub bytes {
+    my $n = shift;
+    return join '', map {
+        $seed = ($seed * 1103515245 + 12345) & 0x7fffffff;
+        chr($seed >> 16 & 255);
+    } 1 .. $n;
+}
+
+my @short = map { bytes($_) } 0 .. 200;
+my @long  = map { bytes($_) } 1000, 4096, 65536, 1 << 20;
+my @sizes = (224, 256, 384, 512);
+
+for (1 .. $rounds) {
+    # short messages, functional interface
+    for my $msg (@short) {
+        jh_256($msg);
+        jh_256_hex($msg);
+        jh_256_base64($msg);
+        jh_512_hex($msg);
+        jh_224($msg) if length($msg) % 4 == 0;
+        jh_384($msg) if length($msg) % 4 == 1;
+    }
+
+    # short messages, OO interface: new, reuse after a digest, clone
+    for my $size (@sizes) {
+        my $ctx = Digest::JH->new($size);
+        for my $msg (@short) {
+            Digest::JH->new($size)->add($msg)->digest;
+            $ctx->add($msg);
+            $ctx->clone->hexdigest if length($msg) % 16 == 0;
+            $ctx->b64digest if length($msg) % 8 == 0;
+        }
+        $ctx->reset;
+    }
+
+    # long messages, whole and streamed in uneven pieces
+    for my $msg (@long) {
+        jh_512($msg);
+        my $ctx = Digest::JH->new(256);
+        my $pos = 0;
+        while ($pos < length $msg) {
+            my $n = 1 + ($pos * 7919 % 3001);
+            $ctx->add(substr $msg, $pos, $n);
+            $pos += $n;
+        }
+        $ctx->digest;
+    }
+
+    # finalization-heavy: peeks and digests of a growing context
+    my $ctx = Digest::JH->new(256);
+    for my $msg (@short[0 .. 63]) {
+        $ctx->add($msg);
+        $ctx->peek_digest;
+        $ctx->clone->digest;
+    }
+
+    # batch interfaces
+    $ctx->digest_suffixes([ @short[0 .. 31] ]);
+    Digest::JH::Fixed->new(64, 256)
+        ->digest_many([ map { bytes(64) } 1 .. 16 ]);
+    chain_many([ @short[1 .. 8] ], 16, size => 256);
+    hmac_jh_256($_, 'key') for @short[0 .. 31];
+}
+
+my ($fh, $file) = tempfile(UNLINK => 1);
+binmode $fh;
+print {$fh} $long[-1] x 4;
+close $fh;
+pieces($file, piece_size => 65536, threads => 1);
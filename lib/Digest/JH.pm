@@ -21,8 +21,200 @@ our @EXPORT_OK = qw(
     jh_256 jh_256_hex jh_256_base64
     jh_384 jh_384_hex jh_384_base64
     jh_512 jh_512_hex jh_512_base64
+    pbkdf2 pbkdf2_verify
+    hkdf hkdf_extract hkdf_expand
+    chain chain_many
+    fixed
+    pieces verify_pieces
+    chunks
+    stats reset_stats
+    resume_file
 );
 
+sub pbkdf2 {
+    my ($password, $salt, $iterations, $dklen, %opts) = @_;
+    my ($dk) = _pbkdf2(
+        [$password], $salt, $iterations, $dklen, $opts{size} || 512
+    );
+    return $dk;
+}
+
+sub pbkdf2_verify {
+    my ($passwords, $salt, $iterations, $dk, %opts) = @_;
+    my $len = defined $dk ? length $dk : 0;
+    # An empty key would compare equal to anything.
+    my @keys = $len ? _pbkdf2(
+        $passwords, $salt, $iterations, $len, $opts{size} || 512
+    ) : ();
+    # Compare every byte, so the time taken does not depend on where
+    # a candidate first differs.
+    return map {
+        my $key = $keys[$_];
+        defined $key and length $key == $len and ($key ^ $dk) !~ tr/\0//c;
+    } 0 .. $#$passwords;
+}
+
+sub hkdf_extract {
+    my ($ikm, $salt, %opts) = @_;
+    return _hkdf_extract($ikm, defined $salt ? $salt : '', $opts{size} || 512);
+}
+
+sub hkdf_expand {
+    my ($prk, $info, $length, %opts) = @_;
+    return _hkdf_expand(
+        $prk, defined $info ? $info : '', $length, $opts{size} || 512
+    );
+}
+
+sub hkdf {
+    my ($ikm, $salt, $info, $length, %opts) = @_;
+    my $prk = hkdf_extract($ikm, $salt, %opts);
+    return undef unless defined $prk;
+    return hkdf_expand($prk, $info, $length, %opts);
+}
+
+sub chain {
+    my ($seed, $count, %opts) = @_;
+    my ($digest) = _chain([$seed], $count, $opts{size} || 512);
+    return $digest;
+}
+
+sub chain_many {
+    my ($seeds, $count, %opts) = @_;
+    return _chain($seeds, $count, $opts{size} || 512);
+}
+
+sub fixed {
+    require Digest::JH::Fixed;
+    return Digest::JH::Fixed->new(@_);
+}
+
+# Takes a path or a filehandle.
+sub _open_input {
+    my ($file) = @_;
+    return $file if ref $file or ref \$file eq 'GLOB';
+    open my $fh, '<', $file or do {
+        require Carp;
+        Carp::croak("Can't open $file: $!");
+    };
+    binmode $fh;
+    return $fh;
+}
+
+sub pieces {
+    my ($file, %opts) = @_;
+    my $size = $opts{size} || 256;
+    my $piece_size = defined $opts{piece_size} ? $opts{piece_size} : 262144;
+    my $threads = $opts{threads} || 0;
+    return undef unless $size =~ /\A(?:224|256|384|512)\z/
+        and $piece_size =~ /\A[0-9]+\z/
+        and $piece_size >= 1 and $piece_size <= 1 << 30
+        and $threads =~ /\A[0-9]+\z/ and $threads <= 0xffffffff;
+
+    my $digests = _pieces(
+        _open_input($file), $piece_size, $size, $threads
+    );
+    unless (defined $digests) {
+        require Carp;
+        Carp::croak("Can't read $file: $!");
+    }
+    return $digests;
+}
+
+sub verify_pieces {
+    my ($file, $expected, %opts) = @_;
+    my $digests = pieces($file, %opts);
+    unless (defined $digests) {
+        require Carp;
+        Carp::croak('Invalid options');
+    }
+    my $len = ($opts{size} || 256) >> 3;
+    my ($have, $want) = (length $digests, length $expected);
+    my $count = int((($have > $want ? $have : $want) + $len - 1) / $len);
+    # a piece past the end of either list is a mismatch
+    return grep {
+        my $end = ($_ + 1) * $len;
+        $end > $have or $end > $want
+            or substr($digests, $_ * $len, $len)
+            ne substr($expected, $_ * $len, $len);
+    } 0 .. $count - 1;
+}
+
+sub chunks {
+    my ($file, %opts) = @_;
+    my $size = $opts{size} || 256;
+    my $avg = defined $opts{avg} ? $opts{avg} : 8192;
+    my $threads = $opts{threads} || 0;
+    unless ($avg =~ /\A[0-9]+\z/ and $avg >= 64 and $avg <= 1 << 28) {
+        require Carp;
+        Carp::croak('Invalid options');
+    }
+    my $min = defined $opts{min} ? $opts{min} : $avg >> 2;
+    my $max = defined $opts{max} ? $opts{max} : $avg << 3;
+    unless ($size =~ /\A(?:224|256|384|512)\z/
+        and $min =~ /\A[0-9]+\z/ and $max =~ /\A[0-9]+\z/
+        and $min >= 1 and $min <= $avg and $avg <= $max
+        and $max <= 1 << 31
+        and $threads =~ /\A[0-9]+\z/ and $threads <= 0xffffffff)
+    {
+        require Carp;
+        Carp::croak('Invalid options');
+    }
+
+    my $chunks = _chunks(
+        _open_input($file), $min, $avg, $max, $size, $threads
+    );
+    unless (defined $chunks) {
+        require Carp;
+        Carp::croak("Can't read $file: $!");
+    }
+    return @$chunks;
+}
+
+sub resume_file {
+    my ($path, $checkpoint) = @_;
+
+    my $ctx;
+    if ($checkpoint =~ /\A(?:224|256|384|512)\z/) {
+        $ctx = __PACKAGE__->new($checkpoint);
+    }
+    else {
+        $ctx = __PACKAGE__->thaw($checkpoint);
+    }
+    unless ($ctx) {
+        require Carp;
+        Carp::croak('Invalid checkpoint');
+    }
+
+    my $offset = $ctx->bytes_hashed;
+
+    open my $fh, '<', $path or do {
+        require Carp;
+        Carp::croak("Can't open $path: $!");
+    };
+    binmode $fh;
+    if (-s $fh < $offset) {
+        require Carp;
+        Carp::croak("$path is shorter than the checkpoint offset");
+    }
+    seek $fh, $offset, 0 or do {
+        require Carp;
+        Carp::croak("Can't seek in $path: $!");
+    };
+
+    my ($n, $buf);
+    while ($n = read $fh, $buf, 65536) {
+        $ctx->add($buf);
+    }
+    unless (defined $n) {
+        require Carp;
+        Carp::croak("Read failed: $!");
+    }
+    close $fh;
+
+    return ($ctx->peek_digest, $ctx->freeze);
+}
+
 sub add_bits {
     my ($self, $data, $bits) = @_;
     if (2 == @_) {
@@ -61,6 +253,8 @@ Digest::JH - Perl interface to the JH digest algorithm
     $digest = $ctx->hexdigest;
     $digest = $ctx->b64digest;
 
+    $digest = $ctx->peek_hexdigest;  # does not reset $ctx
+
 =head1 DESCRIPTION
 
 The C<Digest::JH> module provides an interface to the JH message
@@ -106,6 +300,219 @@ digest encoded as a hexadecimal string.
 Logically joins the arguments into a single string, and returns its JH
 digest encoded as a Base64 string, without any trailing padding.
 
+=head2 pbkdf2($password, $salt, $iterations, $dklen, size => 512)
+
+    $key = pbkdf2($password, $salt, 10_000, 32);
+
+Returns a C<$dklen>-byte key derived with PBKDF2 (RFC 8018), using HMAC
+over JH as the pseudorandom function. The C<size> option selects the
+JH output size, and defaults to 512. The padded password is hashed only
+once, and when the key is longer than one digest, its blocks are
+computed side by side in the CPU's vector lanes. Returns C<undef> if the
+size is invalid, the iteration count is zero, or C<$dklen> is negative
+or longer than RFC 8018 allows (2**32 - 1 digests).
+
+=head2 pbkdf2_verify(\@passwords, $salt, $iterations, $key, size => 512)
+
+    @ok = pbkdf2_verify(\@candidates, $salt, 10_000, $stored_key);
+
+Derives a key from each candidate password, with the length of C<$key>,
+and returns a list of flags telling which of them are equal to C<$key>.
+All the candidates are iterated together, which keeps the vector lanes
+busy even for single-block keys. Every flag is false if C<$key> is
+empty or undefined, or if the key cannot be derived, for instance
+because the size is invalid.
+
+=head2 hkdf($ikm, $salt, $info, $length, size => 512)
+
+    $key = hkdf($shared_secret, $salt, 'client write key', 32);
+
+Returns C<$length> bytes of output keying material derived with HKDF
+(RFC 5869), using HMAC over JH. The C<size> option selects the JH
+output size, and defaults to 512. Returns C<undef> if the size is
+invalid or C<$length> exceeds 255 digests.
+
+=head2 hkdf_extract($ikm, $salt, size => 512)
+
+Returns the pseudorandom key of the HKDF-Extract step. An undefined or
+empty salt stands for a string of zeros.
+
+=head2 hkdf_expand($prk, $info, $length, size => 512)
+
+Returns C<$length> bytes from the HKDF-Expand step.
+
+=head2 chain($seed, $count, size => 512)
+
+    $anchor = chain($secret, 10_000, size => 256);
+
+Returns the result of hashing C<$seed> C<$count> times, each step
+hashing the digest of the previous one, as used by hash-chain one-time
+passwords and hash-based signatures. The C<size> option selects the JH
+output size, and defaults to 512. With a count of zero, the seed is
+returned unchanged. Every step after the first is a fixed-length hash
+whose padding is precomputed, and the state never leaves the C code,
+which makes this much faster than calling C<jh_256> in a loop. Returns
+C<undef> if the size is invalid.
+
+=head2 chain_many(\@seeds, $count, size => 512)
+
+    @anchors = chain_many(\@secrets, 10_000, size => 256);
+
+Returns the list of chain results for the given seeds. The chains are
+iterated side by side in the CPU's vector lanes, so they cost much less
+than separate calls to C<chain>.
+
+=head2 fixed($length, $algorithm)
+
+    $node_hash = fixed(65, 256);
+    $digest = $node_hash->("\x01" . $left . $right);
+
+Returns a L<Digest::JH::Fixed> engine that hashes messages of exactly
+C<$length> bytes, which can be called as a code reference. The
+algorithm defaults to 512.
+
+=head2 pieces($file, piece_size => 262144, size => 256, threads => 0)
+
+    $digests = pieces('image.iso', piece_size => 1 << 20);
+
+Cuts the file into pieces of C<piece_size> bytes (the last one may be
+shorter), and returns the concatenation of the JH digests of the
+pieces, of C<size> bits each. C<$file> is a path or an open filehandle,
+which should be in binary mode and is read to its end.
+
+The file is read once, sequentially. Pieces are hashed by C<threads>
+threads, one per CPU by default, while the next pieces are read, with
+each thread hashing several pieces at a time in the CPU's vector lanes.
+Without thread support, the pieces are hashed by the calling thread.
+Returns C<undef> if the options are invalid: a size other than those
+above, a C<piece_size> that is not an integer from 1 to 1 GiB, or a
+C<threads> that is not a non-negative integer. Croaks if the file cannot
+be read.
+
+=head2 verify_pieces($file, $digests, %options)
+
+    @bad = verify_pieces('image.iso', $digests, piece_size => 1 << 20);
+
+Hashes the file like C<pieces>, with the same options, and returns the
+indices of the pieces whose digests differ from those in C<$digests>.
+Pieces missing from either the file or C<$digests> are also reported.
+Croaks if the options are invalid or the file cannot be read.
+
+=head2 chunks($file, %options)
+
+    for my $chunk (chunks($fh, avg => 8192)) {
+        my ($offset, $length, $digest) = @$chunk;
+        ...
+    }
+
+Cuts the file into content-defined chunks, and returns a list of
+references to the offset, length and JH digest of each chunk. Chunk
+boundaries depend only on the bytes just before them, so inserting or
+removing data only changes the chunks around the edit, which makes the
+digests suitable for deduplication. The options are:
+
+=over
+
+=item avg
+
+The average chunk size, from 64 bytes to 256 MiB. Defaults to 8192.
+
+=item min
+
+=item max
+
+The smallest and largest chunk sizes, which default to a quarter and
+eight times the average. They must be positive integers with C<min> no
+larger than C<avg> and C<max> no smaller, and C<max> at most 2 GiB.
+Only the last chunk may be smaller than C<min>.
+
+=item size
+
+The JH output size: one of 224, 256, 384, 512. Defaults to 256.
+
+=item threads
+
+The number of hashing threads, as for C<pieces>.
+
+=back
+
+Boundaries are found with FastCDC, a Gear rolling hash over the last 32
+bytes with normalized chunking, in one pass over the file. While the
+next part of the file is read and cut, the chunks already cut are hashed
+by the threads, several at a time in the CPU's vector lanes. Croaks if
+the options are invalid, as C<verify_pieces> does, or if the file cannot
+be read.
+
+=head2 stats
+
+    my $stats = Digest::JH::stats();
+    printf "%d bytes in %d blocks\n", @$stats{qw(bytes blocks)};
+
+Returns a hash reference of usage counters, summed over all threads
+since the module was loaded or the counters were last reset:
+
+=over
+
+=item bytes
+
+Message bytes hashed.
+
+=item blocks
+
+64-byte blocks compressed, including padding blocks.
+
+=item finals
+
+Digests computed.
+
+=item buffered
+
+Bytes copied through the block buffer of a context before being
+compressed, as opposed to read directly by the vector lanes.
+
+=item contexts_allocated, contexts_freed
+
+C<Digest::JH> objects created, by C<new>, C<clone> or C<thaw>, and
+destroyed.
+
+=item kernel_core, kernel_lanes2, kernel_lanes4, kernel_chain1,
+kernel_chain2, kernel_chain4, kernel_fixed1, kernel_fixed2, kernel_fixed4
+
+Calls of each compression routine: C<core> compresses one block of one
+context, the C<lanes> routines one block of 2 or 4 messages side by
+side, the C<chain> routines the links of 1, 2 or 4 hash chains, and the
+C<fixed> routines whole messages of fixed length.
+
+=back
+
+The counters are only compiled in when the module is built with
+C<JH_STATS> set in the environment of C<perl Makefile.PL>; otherwise
+C<stats> returns C<undef>. Each thread counts on its own, so counting
+costs no locking, and the counts of a thread are kept when it exits.
+
+=head2 reset_stats
+
+Returns the counters as C<stats> does, and sets them to zero. Counts
+made by other threads during the reset may be lost.
+
+=head2 resume_file($path, $checkpoint)
+
+    ($digest, $checkpoint) = resume_file($path, 256);
+    # ... $path grows by appending ...
+    ($digest, $checkpoint) = resume_file($path, $checkpoint);
+
+Returns the binary JH digest of the file at C<$path> and a checkpoint
+for the next call. The checkpoint is the C<freeze>d state after the last
+byte read, which also records how many bytes have been hashed, so a
+later call only reads and hashes the bytes appended since. For the
+first call, pass the algorithm (224, 256, 384 or 512) instead of a
+checkpoint.
+
+The file is assumed to change only by appending: data before the
+checkpoint offset is not read again, so changes to it are not detected.
+Croaks if the checkpoint is invalid, the file cannot be read, or it is
+shorter than the checkpoint offset.
+
 =head1 METHODS
 
 The object-oriented interface to C<Digest::JH> is identical to that
@@ -124,6 +531,114 @@ The constructor requires the algorithm to be specified. It must be one of:
 
 Returns the algorithm used by the object.
 
+=head2 peek_digest
+
+=head2 peek_hexdigest
+
+=head2 peek_b64digest
+
+    $running = $ctx->peek_hexdigest;
+
+Returns the digest of the data added so far, like C<digest>,
+C<hexdigest> and C<b64digest>, but leaves the object unchanged so that
+more data can be added afterwards. This is cheaper than taking the
+digest of a C<clone>.
+
+=head2 digest_suffixes
+
+=head2 hexdigest_suffixes
+
+=head2 b64digest_suffixes
+
+    @digests = $ctx->hexdigest_suffixes(\@suffixes);
+
+Returns, for each string in the array reference, the digest of the data
+added so far followed by that string. The object itself is not changed.
+This replaces a C<clone>, C<add> and C<digest> per suffix, and the
+suffixes are hashed several at a time in the lanes of the CPU's vector
+registers where these are available.
+
+=head2 freeze
+
+    $frozen = $ctx->freeze;
+
+Returns a binary string holding the state of the running computation,
+so that it can be resumed later, possibly on another host, without
+adding the same data again. The string is at most 204 bytes long and
+does not depend on the platform. Returns C<undef> if the state cannot
+be saved, which is the case after adding a number of bits that is not a
+multiple of 8.
+
+=head2 thaw
+
+    $ctx = Digest::JH->thaw($frozen);
+
+Constructs a new object from the output of C<freeze>. Returns C<undef>
+if the string is not a valid saved state.
+
+=head2 bytes_hashed
+
+    $offset = $ctx->bytes_hashed;
+
+Returns the number of bytes added so far, or C<undef> after adding a
+number of bits that is not a multiple of 8. This survives C<freeze> and
+C<thaw>, which is how C<resume_file> knows where to continue.
+
+=head2 base64_padded_digest
+
+Like C<b64digest>, but pads the result with trailing C<=> characters so
+that its length is a multiple of 4.
+
+=head1 TRACING
+
+Where F<sys/sdt.h> is installed at build time (it comes with SystemTap,
+for instance in the C<systemtap-sdt-dev> or C<systemtap-sdt-devel>
+packages), the module has static tracepoints of provider C<digest_jh>
+for SystemTap, C<bpftrace> and other USDT tools. An untraced probe is a
+single nop. Building with C<-DJH_NO_PROBES> leaves them out. The probes
+and their arguments are:
+
+=over
+
+=item context_create(object, bits)
+
+A C<Digest::JH> object is created by C<new>, C<clone> or C<thaw>.
+
+=item context_destroy(object)
+
+A C<Digest::JH> object is destroyed.
+
+=item add(object, length), add_done(object, length)
+
+Before and after each argument of the C<add> method is hashed.
+
+=item compress(context, blocks)
+
+A context compresses one or more 64-byte blocks in a row.
+
+=item batch(kind, messages, bits)
+
+A batch of messages starts to be hashed in vector lanes; C<kind> is
+C<multi> for messages that each continue a context, as in
+C<digest_suffixes>, C<pieces> or the HMAC and Merkle log batches,
+C<chain> for the links of hash chains and C<fixed> for messages of a
+fixed length.
+
+=item final(context, bits)
+
+A digest is output.
+
+=back
+
+For example, to see the distribution of the lengths passed to C<add> and
+the time each call takes:
+
+    bpftrace -e '
+        usdt:/path/to/JH.so:digest_jh:add {
+            @len = hist(arg1); @start[tid] = nsecs }
+        usdt:/path/to/JH.so:digest_jh:add_done /@start[tid]/ {
+            @ns = hist(nsecs - @start[tid]); delete(@start[tid]) }'
+
 =head1 SEE ALSO
 
 L<Digest>
@@ -0,0 +1,92 @@
+package Digest::JH::DRBG;
+
+use strict;
+use warnings;
+
+use Digest::JH ();
+
+our $VERSION = $Digest::JH::VERSION;
+
+
+1;
+
+__END__
+
+=head1 NAME
+
+Digest::JH::DRBG - Deterministic random bit generator based on JH
+
+=head1 SYNOPSIS
+
+    use Digest::JH::DRBG;
+
+    $drbg = Digest::JH::DRBG->new($entropy, $nonce, $personalization);
+
+    $bytes = $drbg->bytes(16);
+    $bytes = $drbg->generate(256, $additional_input);
+
+    $drbg->reseed($entropy, $additional_input);
+
+=head1 DESCRIPTION
+
+C<Digest::JH::DRBG> implements the Hash_DRBG mechanism of NIST SP
+800-90A with JH-512 as the hash function, using the parameters the
+standard gives for SHA-512: an 888-bit internal state and a security
+strength of 256 bits. It does not gather entropy itself; the caller
+supplies it.
+
+The output blocks of one request are hashed together in the CPU's
+vector lanes. The C<bytes> method serves small reads from a buffer that
+is refilled 2048 bytes at a time, so drawing a few bytes does not cost
+a full request.
+
+=head1 METHODS
+
+=head2 new
+
+    $drbg = Digest::JH::DRBG->new($entropy, $nonce, $personalization)
+
+Instantiates the generator. The nonce and personalization string are
+optional. The entropy input should hold at least 32 bytes of entropy.
+
+=head2 reseed
+
+    $drbg->reseed($entropy, $additional_input)
+
+Reseeds the generator, with an optional additional input. Any buffered
+output is discarded.
+
+=head2 generate
+
+    $bytes = $drbg->generate($length, $additional_input)
+
+Performs one Hash_DRBG generate request for C<$length> bytes, with an
+optional additional input. Returns C<undef> if C<$length> is over 65536
+or if the generator has to be reseeded, which happens after 2**48
+requests.
+
+=head2 bytes
+
+    $bytes = $drbg->bytes($length)
+
+Returns the next C<$length> bytes of the buffered output stream, which
+is the concatenation of the outputs of successive 2048-byte generate
+requests without additional input. Returns C<undef> if the generator
+has to be reseeded.
+
+=head1 SEE ALSO
+
+L<Digest::JH>
+
+=head1 AUTHOR
+
+gray, <gray at cpan.org>
+
+=head1 COPYRIGHT AND LICENSE
+
+Copyright (C) 2010-2011 gray <gray at cpan.org>, all rights reserved.
+
+This library is free software; you can redistribute it and/or modify it
+under the same terms as Perl itself.
+
+=cut
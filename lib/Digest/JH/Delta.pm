@@ -0,0 +1,195 @@
+package Digest::JH::Delta;
+
+use strict;
+use warnings;
+use parent qw(Exporter);
+
+use Digest::JH ();
+
+our $VERSION = $Digest::JH::VERSION;
+
+our @EXPORT_OK = qw(signature delta patch);
+
+sub _croak {
+    require Carp;
+    Carp::croak(@_);
+}
+
+sub signature {
+    my ($file, %opts) = @_;
+    my $block_size = defined $opts{block_size} ? $opts{block_size} : 2048;
+    my $strong_len = defined $opts{strong_len} ? $opts{strong_len} : 16;
+    return undef unless $block_size =~ /\A[0-9]+\z/
+        and $block_size >= 1 and $block_size <= 0xffffffff
+        and $strong_len =~ /\A[0-9]+\z/
+        and $strong_len >= 1 and $strong_len <= 32;
+    my $sig = _signature(
+        Digest::JH::_open_input($file), $block_size, $strong_len
+    );
+    _croak("Can't read $file: $!") unless defined $sig;
+    return $sig;
+}
+
+sub delta {
+    my ($file, $signature) = @_;
+    my $delta = _delta(Digest::JH::_open_input($file), $signature);
+    _croak("Can't read $file: $!") unless defined $delta;
+    return $delta;
+}
+
+sub patch {
+    my ($basis, $delta, $out) = @_;
+    my $fh = Digest::JH::_open_input($basis);
+    my $result = '';
+    my $write = defined $out
+        ? sub { print {$out} $_[0] or _croak("Can't write: $!") }
+        : sub { $result .= $_[0] };
+
+    _croak('Invalid delta')
+        unless length $delta >= 8 and substr($delta, 0, 4) eq 'JHRD';
+    my $block_size = unpack 'N', substr $delta, 4, 4;
+    _croak('Invalid delta') unless $block_size;
+    my $basis_len = -s $fh;
+    _croak("Can't stat $basis: $!") unless defined $basis_len;
+
+    # Check every record before writing anything: [ offset, length ] for
+    # a copy from the basis, or [ undef, length, position ] for literal
+    # data in the delta.
+    my ($pos, @records) = (8);
+    while ($pos < length $delta) {
+        my $type = substr $delta, $pos++, 1;
+        if ($type eq 'C' and $pos + 12 <= length $delta) {
+            my ($hi, $lo, $count) = unpack 'NNN', substr $delta, $pos, 12;
+            $pos += 12;
+            my $start = ($hi * 2**32 + $lo) * $block_size;
+            my $end = $start + $count * $block_size;
+            # only the last block of the basis may be short
+            _croak('Delta does not match the basis')
+                if $count and $end - $block_size >= $basis_len;
+            $end = $basis_len if $end > $basis_len;
+            push @records, [ $start, $end - $start ] if $count;
+        }
+        elsif ($type eq 'L' and $pos + 4 <= length $delta) {
+            my $len = unpack 'N', substr $delta, $pos, 4;
+            _croak('Invalid delta') if $pos + 4 + $len > length $delta;
+            push @records, [ undef, $len, $pos + 4 ];
+            $pos += 4 + $len;
+        }
+        else {
+            _croak('Invalid delta');
+        }
+    }
+
+    for (@records) {
+        my ($start, $len, $at) = @$_;
+        unless (defined $start) {
+            $write->(substr $delta, $at, $len);
+            next;
+        }
+        seek $fh, $start, 0 or _croak("Can't seek $basis: $!");
+        while ($len > 0) {
+            my $n = read $fh, my $buf, $len > 65536 ? 65536 : $len;
+            _croak("Can't read $basis: $!") unless defined $n;
+            _croak("Can't read $basis: unexpected end of file") unless $n;
+            $write->($buf);
+            $len -= $n;
+        }
+    }
+    return defined $out ? 1 : $result;
+}
+
+
+1;
+
+__END__
+
+=head1 NAME
+
+Digest::JH::Delta - rsync-style deltas with JH strong checksums
+
+=head1 SYNOPSIS
+
+    use Digest::JH::Delta qw(signature delta patch);
+
+    # on the side with the old file
+    $sig = signature('old.db', block_size => 2048, strong_len => 16);
+
+    # on the side with the new file
+    $delta = delta('new.db', $sig);
+
+    # back on the side with the old file
+    open my $out, '>', 'new.db' or die;
+    patch('old.db', $delta, $out);
+
+=head1 DESCRIPTION
+
+C<Digest::JH::Delta> implements the rsync algorithm. A signature of a
+basis file lists, for each of its blocks, rsync's rolling weak checksum
+and a truncated JH-256 digest. The delta of a new file against that
+signature is found by sliding a window over the new file one byte at a
+time: the weak checksum is updated in constant time at each step, and a
+block whose weak checksum is in the signature is confirmed with JH. The
+delta is made of copies of basis blocks and literal data, and applying
+it to the basis gives the new file.
+
+The blocks of a signature are hashed side by side in the CPU's vector
+lanes. When the delta finds a weak match, the following aligned blocks
+whose weak checksums are also in the signature are hashed along with
+it, so that runs of unchanged blocks are confirmed a few at a time.
+
+Files are given as paths or filehandles; a filehandle passed to
+C<patch> must be seekable.
+
+=head1 FUNCTIONS
+
+=head2 signature($file, %options)
+
+Returns the signature of the file. The options are:
+
+=over
+
+=item block_size
+
+The block size, in bytes, from 1 to 0xffffffff. Defaults to 2048.
+
+=item strong_len
+
+The number of bytes of each JH-256 digest to keep, from 1 to 32.
+Defaults to 16.
+
+=back
+
+Returns C<undef> for invalid options, and croaks if the file cannot be
+read.
+
+=head2 delta($file, $signature)
+
+Returns the delta of the file against the signature. Croaks if the file
+cannot be read or the signature is invalid.
+
+=head2 patch($basis, $delta, $out)
+
+Applies the delta to the basis file, and prints the result to the
+filehandle C<$out>, returning true, or returns it as a string if there is
+no filehandle. Croaks if the delta is invalid, if it copies blocks
+that the basis does not have, or if a file cannot be read or written.
+The delta is checked before anything is written.
+
+=head1 SEE ALSO
+
+L<Digest::JH>
+
+L<https://rsync.samba.org/tech_report/>
+
+=head1 AUTHOR
+
+gray, <gray at cpan.org>
+
+=head1 COPYRIGHT AND LICENSE
+
+Copyright (C) 2010-2011 gray <gray at cpan.org>, all rights reserved.
+
+This library is free software; you can redistribute it and/or modify it
+under the same terms as Perl itself.
+
+=cut
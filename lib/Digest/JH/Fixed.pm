@@ -0,0 +1,102 @@
+package Digest::JH::Fixed;
+
+use strict;
+use warnings;
+
+use Digest::JH ();
+
+use overload
+    '&{}'    => sub { my $self = shift; sub { $self->digest(@_) } },
+    fallback => 1;
+
+our $VERSION = $Digest::JH::VERSION;
+
+
+1;
+
+__END__
+
+=head1 NAME
+
+Digest::JH::Fixed - JH digests of fixed-length messages
+
+=head1 SYNOPSIS
+
+    use Digest::JH::Fixed;
+
+    # JH-256 of 65-byte Merkle tree nodes
+    $node = Digest::JH::Fixed->new(65, 256);
+
+    $digest = $node->digest("\x01" . $left . $right);
+    $digest = $node->("\x01" . $left . $right);
+
+    @digests = $node->hexdigest_many(\@nodes);
+
+=head1 DESCRIPTION
+
+C<Digest::JH::Fixed> hashes messages that all have the same length, such
+as tree nodes, keys or record identifiers. The padding blocks, which
+depend only on the message length, are built once when the engine is
+created. Each message is then hashed without a context: its words are
+loaded directly from the string, and only the blocks it needs are
+compressed.
+
+An engine can be called as a code reference, which is the same as
+calling its C<digest> method.
+
+=head1 METHODS
+
+=head2 new
+
+    $engine = Digest::JH::Fixed->new($length, $algorithm)
+
+Returns an engine for messages of C<$length> bytes. The algorithm must
+be one of: 224, 256, 384, 512, and defaults to 512. Returns C<undef> if
+the algorithm is invalid.
+
+=head2 digest($data)
+
+=head2 hexdigest($data)
+
+=head2 b64digest($data)
+
+Returns the digest of the data, encoded as a binary, hexadecimal or
+unpadded Base64 string. Returns C<undef> if the data does not have the
+engine's length.
+
+=head2 digest_many(\@messages)
+
+=head2 hexdigest_many(\@messages)
+
+=head2 b64digest_many(\@messages)
+
+Returns the list of digests of the messages, which are hashed side by
+side in the CPU's vector lanes. Messages that do not have the engine's
+length get C<undef>.
+
+=head2 length
+
+Returns the message length of the engine.
+
+=head2 algorithm
+
+=head2 hashsize
+
+Returns the algorithm used by the engine.
+
+=head1 SEE ALSO
+
+L<Digest::JH>
+
+=head1 AUTHOR
+
+gray, <gray at cpan.org>
+
+=head1 COPYRIGHT AND LICENSE
+
+Copyright (C) 2010-2011 gray <gray at cpan.org>, all rights reserved.
+
+This library is free software; you can redistribute it and/or modify it
+under the same terms as Perl itself.
+
+=cut
@@ -0,0 +1,143 @@
+package Digest::JH::HMAC;
+
+use strict;
+use warnings;
+use parent qw(Exporter Digest::base);
+
+use Digest::JH ();
+
+our $VERSION = $Digest::JH::VERSION;
+
+our @EXPORT_OK = qw(
+    hmac_jh_224 hmac_jh_224_hex hmac_jh_224_base64
+    hmac_jh_256 hmac_jh_256_hex hmac_jh_256_base64
+    hmac_jh_384 hmac_jh_384_hex hmac_jh_384_base64
+    hmac_jh_512 hmac_jh_512_hex hmac_jh_512_base64
+);
+
+
+1;
+
+__END__
+
+=head1 NAME
+
+Digest::JH::HMAC - HMAC using the JH digest algorithm
+
+=head1 SYNOPSIS
+
+    # Functional interface
+    use Digest::JH::HMAC qw(hmac_jh_256 hmac_jh_256_hex);
+
+    $mac = hmac_jh_256($data, $key);
+    $mac = hmac_jh_256_hex($data, $key);
+
+    # Object-oriented interface
+    use Digest::JH::HMAC;
+
+    $hmac = Digest::JH::HMAC->new($key, 256);
+
+    $hmac->add($data);
+    $mac = $hmac->hexdigest;
+
+    @macs = $hmac->hexdigest_many(\@messages);
+
+=head1 DESCRIPTION
+
+The C<Digest::JH::HMAC> module computes HMAC (RFC 2104) message
+authentication codes with JH as the hash function, using the 64-byte
+JH block size.
+
+The key is processed once, when the object is constructed: the hash
+states after the inner and outer padded key blocks are saved, and every
+message starts from a copy of them. Reusing one object for many
+messages therefore avoids hashing the key again.
+
+=head1 FUNCTIONS
+
+The following functions are provided by the C<Digest::JH::HMAC>
+module. None of these functions are exported by default.
+
+=head2 hmac_jh_224($data, $key)
+
+=head2 hmac_jh_256($data, $key)
+
+=head2 hmac_jh_384($data, $key)
+
+=head2 hmac_jh_512($data, $key)
+
+Returns the HMAC of the data encoded as a binary string.
+
+=head2 hmac_jh_224_hex($data, $key)
+
+=head2 hmac_jh_256_hex($data, $key)
+
+=head2 hmac_jh_384_hex($data, $key)
+
+=head2 hmac_jh_512_hex($data, $key)
+
+Returns the HMAC of the data encoded as a hexadecimal string.
+
+=head2 hmac_jh_224_base64($data, $key)
+
+=head2 hmac_jh_256_base64($data, $key)
+
+=head2 hmac_jh_384_base64($data, $key)
+
+=head2 hmac_jh_512_base64($data, $key)
+
+Returns the HMAC of the data encoded as a Base64 string, without any
+trailing padding.
+
+=head1 METHODS
+
+The object-oriented interface to C<Digest::JH::HMAC> is identical to
+that described by C<Digest>, except for the following:
+
+=head2 new
+
+    $hmac = Digest::JH::HMAC->new($key, 256)
+
+The constructor requires the key and the algorithm, which must be one
+of: 224, 256, 384, 512.
+
+=head2 algorithm
+
+=head2 hashsize
+
+Returns the algorithm used by the object.
+
+=head2 base64_padded_digest
+
+Like C<b64digest>, but with trailing C<=> padding.
+
+=head2 digest_many
+
+=head2 hexdigest_many
+
+=head2 b64digest_many
+
+    @macs = $hmac->digest_many(\@messages);
+
+Returns the HMAC of each message in the array reference, in order. The
+messages are processed independently of any data passed to C<add>,
+which is left untouched.
+
+=head1 SEE ALSO
+
+L<Digest::JH>
+
+L<Digest::HMAC>
+
+=head1 AUTHOR
+
+gray, <gray at cpan.org>
+
+=head1 COPYRIGHT AND LICENSE
+
+Copyright (C) 2010-2011 gray <gray at cpan.org>, all rights reserved.
+
+This library is free software; you can redistribute it and/or modify it
+under the same terms as Perl itself.
+
+=cut
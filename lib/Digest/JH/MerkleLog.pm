@@ -0,0 +1,235 @@
+package Digest::JH::MerkleLog;
+
+use strict;
+use warnings;
+
+use Digest::JH ();
+
+our $VERSION = $Digest::JH::VERSION;
+
+sub new {
+    my ($class, %opts) = @_;
+    my $size = $opts{size} || 256;
+    return $class->_open($size, $opts{file}) if defined $opts{file};
+    return $class->_new($size, exists $opts{nodes} ? $opts{nodes} : 1);
+}
+
+sub _bits {
+    my ($self, %opts) = @_;
+    return ref $self ? $self->hashsize : $opts{size} || 256;
+}
+
+sub _node {
+    my ($bits, $left, $right) = @_;
+    return Digest::JH->new($bits)->add("\x01", $left, $right)->digest;
+}
+
+# RFC 9162, section 2.1.3.2
+sub verify_inclusion {
+    my ($self, $data, $index, $size, $proof, $root, %opts) = @_;
+    my $bits = $self->_bits(%opts);
+    return 0 if $index >= $size;
+    my ($fn, $sn) = ($index, $size - 1);
+    my $r = Digest::JH->new($bits)->add("\0", $data)->digest;
+    for my $p (@$proof) {
+        return 0 unless $sn;
+        if ($fn & 1 or $fn == $sn) {
+            $r = _node($bits, $p, $r);
+            until ($fn & 1 or $fn == 0) {
+                $fn >>= 1;
+                $sn >>= 1;
+            }
+        }
+        else {
+            $r = _node($bits, $r, $p);
+        }
+        $fn >>= 1;
+        $sn >>= 1;
+    }
+    return $sn == 0 && $r eq $root ? 1 : 0;
+}
+
+# RFC 9162, section 2.1.4.2
+sub verify_consistency {
+    my ($self, $old_size, $size, $old_root, $root, $proof, %opts) = @_;
+    my $bits = $self->_bits(%opts);
+    return 0 if $old_size < 1 or $old_size > $size;
+    return @$proof == 0 && $old_root eq $root ? 1 : 0
+        if $old_size == $size;
+    return 0 unless @$proof;
+    my @path = @$proof;
+    unshift @path, $old_root unless $old_size & ($old_size - 1);
+    my ($fn, $sn) = ($old_size - 1, $size - 1);
+    while ($fn & 1) {
+        $fn >>= 1;
+        $sn >>= 1;
+    }
+    my $fr = my $sr = shift @path;
+    for my $c (@path) {
+        return 0 unless $sn;
+        if ($fn & 1 or $fn == $sn) {
+            $fr = _node($bits, $c, $fr);
+            $sr = _node($bits, $c, $sr);
+            until ($fn & 1 or $fn == 0) {
+                $fn >>= 1;
+                $sn >>= 1;
+            }
+        }
+        else {
+            $sr = _node($bits, $sr, $c);
+        }
+        $fn >>= 1;
+        $sn >>= 1;
+    }
+    return $fr eq $old_root && $sr eq $root && $sn == 0 ? 1 : 0;
+}
+
+
+1;
+
+__END__
+
+=head1 NAME
+
+Digest::JH::MerkleLog - Append-only Merkle tree log hashed with JH
+
+=head1 SYNOPSIS
+
+    use Digest::JH::MerkleLog;
+
+    $log = Digest::JH::MerkleLog->new(size => 256, file => 'log.nodes');
+
+    $log->append(@entries);
+    $root = $log->root;
+
+    $proof = $log->inclusion_proof($index);
+    $ok = $log->verify_inclusion($entries[$index], $index, $log->size,
+        $proof, $root);
+
+    $proof = $log->consistency_proof($old_size);
+    $ok = Digest::JH::MerkleLog->verify_consistency($old_size, $log->size,
+        $old_root, $log->root, $proof, size => 256);
+
+=head1 DESCRIPTION
+
+C<Digest::JH::MerkleLog> is a transparency log: an append-only Merkle
+tree with the shape and hashing of RFC 6962, where a leaf hash is
+C<JH(0x00 . $data)> and an interior node hash is
+C<JH(0x01 . $left . $right)>.
+
+The root of the current tree is computed from its right edge, one hash
+per level, which is all the log keeps in memory. Proofs and the roots of
+earlier trees need the hashes of complete subtrees, so by default the
+log also stores these nodes, about two per leaf, either in memory or in
+a memory-mapped file.
+
+Appended leaves are hashed side by side in the CPU's vector lanes, and
+the new interior nodes are hashed level by level in batches of
+fixed-length messages.
+
+=head1 METHODS
+
+=head2 new
+
+    $log = Digest::JH::MerkleLog->new(%options)
+
+Returns a new log. The options are:
+
+=over
+
+=item size
+
+The JH output size: one of 224, 256, 384, 512. Defaults to 256.
+
+=item file
+
+Stores the nodes in the given memory-mapped file, which is created if
+it does not exist. An existing file is reopened with all its leaves.
+
+=item nodes
+
+When false, and there is no file, only the right edge is kept: the
+current root is available, but not proofs, leaf hashes or earlier roots.
+
+=back
+
+Returns C<undef>, with C<$!> set for a file, on failure.
+
+=head2 append(@leaves)
+
+Appends the leaves, and returns the new size of the log, or C<undef> if
+the node storage cannot be grown.
+
+=head2 size
+
+Returns the number of leaves.
+
+=head2 algorithm
+
+=head2 hashsize
+
+Returns the JH output size of the log.
+
+=head2 root($size)
+
+=head2 hexroot($size)
+
+=head2 b64root($size)
+
+Returns the root of the tree of the first C<$size> leaves, which
+defaults to all of them, encoded as a binary, hexadecimal or unpadded
+Base64 string. Returns C<undef> if the root is not available.
+
+=head2 leaf_hash($index)
+
+Returns the hash of the given leaf, or C<undef>.
+
+=head2 inclusion_proof($index, $size)
+
+Returns a reference to the list of hashes of the audit path of the
+given leaf in the tree of the first C<$size> leaves (all of them by
+default), from the leaf up. Returns C<undef> if the index is not in the
+tree or the nodes are not stored.
+
+=head2 consistency_proof($old_size, $size)
+
+Returns a reference to the list of hashes of the consistency proof
+between the trees of the first C<$old_size> and C<$size> leaves
+(all of them by default), or C<undef>.
+
+=head2 verify_inclusion($data, $index, $size, $proof, $root, %options)
+
+Returns true if the proof shows that the leaf C<$data> is at C<$index>
+in the tree of C<$size> leaves with the given root. This can be called
+as a class method, with a C<size> option for the JH output size (256 by
+default).
+
+=head2 verify_consistency($old_size, $size, $old_root, $root, $proof, %options)
+
+Returns true if the proof shows that the tree of C<$old_size> leaves
+with root C<$old_root> is a prefix of the tree of C<$size> leaves with
+root C<$root>. This can be called as a class method, like
+C<verify_inclusion>.
+
+=head2 sync
+
+Flushes a file-backed log to disk. Returns true on success.
+
+=head1 SEE ALSO
+
+L<Digest::JH>
+
+L<https://www.rfc-editor.org/rfc/rfc6962>
+
+=head1 AUTHOR
+
+gray, <gray at cpan.org>
+
+=head1 COPYRIGHT AND LICENSE
+
+Copyright (C) 2010-2011 gray <gray at cpan.org>, all rights reserved.
+
+This library is free software; you can redistribute it and/or modify it
+under the same terms as Perl itself.
+
+=cut
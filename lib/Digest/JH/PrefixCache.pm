@@ -0,0 +1,101 @@
+package Digest::JH::PrefixCache;
+
+use strict;
+use warnings;
+
+use Digest::JH ();
+
+our $VERSION = $Digest::JH::VERSION;
+
+
+1;
+
+__END__
+
+=head1 NAME
+
+Digest::JH::PrefixCache - JH digests of messages sharing common prefixes
+
+=head1 SYNOPSIS
+
+    use Digest::JH::PrefixCache;
+
+    $cache = Digest::JH::PrefixCache->new(256, 1000);
+
+    # JH-256 of $namespace . $tenant_id . $payload
+    $digest = $cache->hexdigest($namespace . $tenant_id, $payload);
+
+    # A Digest::JH object positioned after the prefix
+    $ctx = $cache->context($prefix);
+
+=head1 DESCRIPTION
+
+C<Digest::JH::PrefixCache> keeps a bounded, least recently used set of
+JH hash states, each taken after hashing one prefix. Hashing a message
+that starts with a cached prefix resumes from the saved state, so only
+the rest of the message is compressed. This pays off when the prefixes
+span one or more 64-byte blocks and are shared by many messages.
+
+=head1 METHODS
+
+=head2 new
+
+    $cache = Digest::JH::PrefixCache->new($algorithm, $capacity)
+
+The algorithm must be one of: 224, 256, 384, 512. The optional capacity
+is the maximum number of prefixes kept, and defaults to 64. Returns
+C<undef> if the algorithm or the capacity is invalid, or the hash table
+for the capacity cannot be allocated.
+
+=head2 digest($prefix, $data, ...)
+
+=head2 hexdigest($prefix, $data, ...)
+
+=head2 b64digest($prefix, $data, ...)
+
+Returns the digest of the prefix followed by the data arguments,
+encoded as a binary, hexadecimal or unpadded Base64 string. The prefix
+is looked up, or hashed and added to the cache.
+
+=head2 context($prefix)
+
+Returns a new L<Digest::JH> object that has already hashed the prefix,
+to which the rest of the message can be added.
+
+=head2 algorithm
+
+=head2 hashsize
+
+Returns the algorithm used by the cache.
+
+=head2 count
+
+Returns the number of cached prefixes.
+
+=head2 hits
+
+=head2 misses
+
+Return the number of lookups that found, or did not find, their prefix
+in the cache.
+
+=head2 clear
+
+Removes all cached prefixes.
+
+=head1 SEE ALSO
+
+L<Digest::JH>
+
+=head1 AUTHOR
+
+gray, <gray at cpan.org>
+
+=head1 COPYRIGHT AND LICENSE
+
+Copyright (C) 2010-2011 gray <gray at cpan.org>, all rights reserved.
+
+This library is free software; you can redistribute it and/or modify it
+under the same terms as Perl itself.
+
+=cut
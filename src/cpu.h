@@ -0,0 +1,60 @@
+/*
+ * Runtime CPU feature detection for the optional SIMD code paths.
+ *
+ * The SIMD routines are compiled with per-function target attributes,
+ * so the module itself is still built for the baseline architecture
+ * and the vector code is only entered when the running CPU supports
+ * it. Define JH_NO_SIMD to compile the portable code only.
+ */
+
+#ifndef JH_CPU_H__
+#define JH_CPU_H__
+
+#if !defined JH_NO_SIMD && (defined __x86_64__ || defined __i386__) \
+    && (defined __clang__ || __GNUC__ > 4 \
+        || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define JH_X86_DISPATCH 1
+#include <immintrin.h>
+#define JH_TARGET(isa) __attribute__((target(isa)))
+#else
+#define JH_X86_DISPATCH 0
+#endif
+
+#define JH_CPU_SSSE3 0x01
+#define JH_CPU_AVX2  0x02
+
+/* Builds without dispatch never ask for the features. */
+#if defined __GNUC__ || defined __clang__
+#define JH_CPU_UNUSED __attribute__((unused))
+#else
+#define JH_CPU_UNUSED
+#endif
+
+/*
+ * The result of jh_cpu_features(), or -1 before the first call. A
+ * benchmark may clear bits here to keep a code path from being taken.
+ */
+static JH_CPU_UNUSED int jh_cpu_cache = -1;
+
+/*
+ * Returns a mask of JH_CPU_* flags. The result is cached after the
+ * first call; concurrent first calls compute the same value, so the
+ * unsynchronized store is harmless.
+ */
+static JH_CPU_UNUSED int
+jh_cpu_features (void) {
+    if (jh_cpu_cache < 0) {
+        int f = 0;
+#if JH_X86_DISPATCH
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("ssse3"))
+            f |= JH_CPU_SSSE3;
+        if (__builtin_cpu_supports("avx2"))
+            f |= JH_CPU_AVX2;
+#endif
+        jh_cpu_cache = f;
+    }
+    return jh_cpu_cache;
+}
+
+#endif
@@ -0,0 +1,399 @@
+/*
+ * rsync-style delta encoding; see delta.h.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "delta.h"
+
+#define SIG_HEADER    20
+#define DELTA_HEADER  8
+#define BATCH_BLOCKS  64
+
+typedef struct {
+    unsigned char *p;
+    size_t len, cap;
+    int failed;
+} jh_delta_buf;
+
+static void
+put (jh_delta_buf *b, const void *src, size_t len) {
+    unsigned char *p;
+    size_t cap;
+
+    if (b->failed)
+        return;
+    if (b->len + len > b->cap) {
+        for (cap = b->cap ? b->cap : 4096; cap < b->len + len; cap *= 2)
+            ;
+        p = realloc(b->p, cap);
+        if (! p) {
+            b->failed = 1;
+            return;
+        }
+        b->p = p;
+        b->cap = cap;
+    }
+    memcpy(b->p + b->len, src, len);
+    b->len += len;
+}
+
+static void
+put_be (jh_delta_buf *b, size_t v, unsigned bytes) {
+    unsigned char be[8];
+    unsigned i;
+
+    for (i = bytes; i--; v >>= 8)
+        be[i] = (unsigned char)v;
+    put(b, be, bytes);
+}
+
+static size_t
+get_be (const unsigned char *p, unsigned bytes) {
+    size_t v = 0;
+    while (bytes--)
+        v = (v << 8) | *p++;
+    return v;
+}
+
+/* Reads until len bytes or the end; returns the count, or -1. */
+static long
+read_full (jh_pieces_reader rd, void *ctx, unsigned char *dst, size_t len) {
+    size_t fill = 0;
+    long r;
+
+    while (fill < len) {
+        r = rd(ctx, dst + fill, len - fill);
+        if (r < 0)
+            return -1;
+        if (r == 0)
+            break;
+        fill += r;
+    }
+    return (long)fill;
+}
+
+/*
+ * rsync's weak checksum: a is the sum of the bytes and b the sum of the
+ * running values of a, both modulo 2^16.
+ */
+static void
+weak_sums (const unsigned char *p, size_t len, unsigned *a, unsigned *b) {
+    unsigned s1 = 0, s2 = 0;
+    while (len--) {
+        s1 += *p++;
+        s2 += s1;
+    }
+    *a = s1 & 0xffff;
+    *b = s2 & 0xffff;
+}
+
+#define WEAK(a, b)  (((unsigned long)(b) << 16) | (a))
+
+long
+jh_delta_signature (jh_pieces_reader rd, void *ctx, size_t block_size,
+                    unsigned strong_len, unsigned char **sig) {
+    const sph_jh_context *starts[BATCH_BLOCKS];
+    const void *data[BATCH_BLOCKS];
+    size_t len[BATCH_BLOCKS], total = 0, n, i;
+    unsigned char *blocks, strong[BATCH_BLOCKS * 32];
+    sph_jh_context start;
+    jh_delta_buf b = { NULL, 0, 0, 0 };
+    unsigned wa, wb;
+    long r;
+    int eof = 0;
+
+    *sig = NULL;
+    if (! block_size || block_size > 0xffffffffUL || ! strong_len
+        || strong_len > 32)
+        return -1;
+    blocks = malloc(BATCH_BLOCKS * block_size);
+    if (! blocks)
+        return -1;
+    sph_jh_init_size(&start, 256);
+
+    put(&b, "JHRS", 4);
+    put_be(&b, 1, 1);
+    put_be(&b, strong_len, 1);
+    put_be(&b, 0, 2);
+    put_be(&b, block_size, 4);
+    put_be(&b, 0, 8);
+
+    /* Blocks are read a batch at a time and hashed side by side. */
+    while (! eof) {
+        for (n = 0; n < BATCH_BLOCKS && ! eof; n++) {
+            r = read_full(rd, ctx, blocks + n * block_size, block_size);
+            if (r < 0)
+                goto fail;
+            if ((size_t)r < block_size)
+                eof = 1;
+            if (! r)
+                break;
+            starts[n] = &start;
+            data[n] = blocks + n * block_size;
+            len[n] = r;
+            total += r;
+        }
+        sph_jh_multi_close(starts, data, len, n, strong, 256);
+        for (i = 0; i < n; i++) {
+            weak_sums(data[i], len[i], &wa, &wb);
+            put_be(&b, WEAK(wa, wb), 4);
+            put(&b, strong + i * 32, strong_len);
+        }
+    }
+    if (b.failed)
+        goto fail;
+    for (i = 20; i-- > 12; total >>= 8)
+        b.p[i] = (unsigned char)total;
+    free(blocks);
+    *sig = b.p;
+    return (long)b.len;
+
+fail:
+    free(blocks);
+    free(b.p);
+    return -1;
+}
+
+/* The parsed signature, with a hash table of the full blocks. */
+typedef struct {
+    size_t block_size, nblocks, last_len;
+    unsigned strong_len;
+    const unsigned char *entries;
+    size_t *head, *next, mask;
+} jh_delta_sig;
+
+static size_t
+sig_slot (const jh_delta_sig *s, unsigned long weak) {
+    return (size_t)(((weak * 2654435761UL) & 0xffffffffUL) >> 8) & s->mask;
+}
+
+static unsigned long
+sig_weak (const jh_delta_sig *s, size_t i) {
+    return (unsigned long)get_be(s->entries + i * (4 + s->strong_len), 4);
+}
+
+static const unsigned char *
+sig_strong (const jh_delta_sig *s, size_t i) {
+    return s->entries + i * (4 + s->strong_len) + 4;
+}
+
+/* Returns the first block with these checksums, or nblocks. */
+static size_t
+sig_find (const jh_delta_sig *s, unsigned long weak,
+          const unsigned char *strong) {
+    size_t i;
+    for (i = s->head[sig_slot(s, weak)]; i < s->nblocks; i = s->next[i])
+        if (sig_weak(s, i) == weak
+            && ! memcmp(sig_strong(s, i), strong, s->strong_len))
+            return i;
+    return s->nblocks;
+}
+
+static int
+sig_has_weak (const jh_delta_sig *s, unsigned long weak) {
+    size_t i;
+    for (i = s->head[sig_slot(s, weak)]; i < s->nblocks; i = s->next[i])
+        if (sig_weak(s, i) == weak)
+            return 1;
+    return 0;
+}
+
+/* Delta output, merging copies of consecutive blocks into one record. */
+typedef struct {
+    jh_delta_buf out;
+    size_t copy_first, copy_count;
+} jh_delta_writer;
+
+static void
+flush_copy (jh_delta_writer *w) {
+    if (! w->copy_count)
+        return;
+    put(&w->out, "C", 1);
+    put_be(&w->out, w->copy_first, 8);
+    put_be(&w->out, w->copy_count, 4);
+    w->copy_count = 0;
+}
+
+static void
+emit_copy (jh_delta_writer *w, size_t block) {
+    if (w->copy_count && block == w->copy_first + w->copy_count
+        && w->copy_count < 0xffffffffUL) {
+        w->copy_count++;
+        return;
+    }
+    flush_copy(w);
+    w->copy_first = block;
+    w->copy_count = 1;
+}
+
+static void
+emit_literal (jh_delta_writer *w, const unsigned char *p, size_t len) {
+    size_t n;
+    if (! len)
+        return;
+    flush_copy(w);
+    for (; len; p += n, len -= n) {
+        n = len < 0x7fffffff ? len : 0x7fffffff;
+        put(&w->out, "L", 1);
+        put_be(&w->out, n, 4);
+        put(&w->out, p, n);
+    }
+}
+
+long
+jh_delta_encode (jh_pieces_reader rd, void *ctx, const unsigned char *sig,
+                 size_t sig_len, unsigned char **delta) {
+    jh_delta_sig s;
+    jh_delta_writer w;
+    sph_jh_fixed fx;
+    sph_jh_context sc;
+    const void *cand[4];
+    unsigned char strong[4 * 32], *buf = NULL;
+    size_t basis_len, cap, fill = 0, pos = 0, lit = 0, i, k, blk, lanes;
+    unsigned a = 0, b = 0, ta, tb;
+    unsigned long weak;
+    int have_weak = 0, eof = 0, matched;
+    long r, ret = -1;
+
+    *delta = NULL;
+    memset(&w, 0, sizeof w);
+    s.head = s.next = NULL;
+    if (sig_len < SIG_HEADER || memcmp(sig, "JHRS", 4) || sig[4] != 1
+        || ! sig[5] || sig[5] > 32)
+        return JH_DELTA_BAD_SIGNATURE;
+    s.strong_len = sig[5];
+    s.block_size = get_be(sig + 8, 4);
+    basis_len = get_be(sig + 12, 8);
+    if (! s.block_size)
+        return JH_DELTA_BAD_SIGNATURE;
+    s.nblocks = basis_len / s.block_size + (basis_len % s.block_size != 0);
+    s.last_len = basis_len - (s.nblocks ? s.nblocks - 1 : 0) * s.block_size;
+    s.entries = sig + SIG_HEADER;
+    if ((sig_len - SIG_HEADER) / (4 + s.strong_len) != s.nblocks
+        || (sig_len - SIG_HEADER) % (4 + s.strong_len))
+        return JH_DELTA_BAD_SIGNATURE;
+
+    /* Chains are in block order, so the first match is the lowest. */
+    for (s.mask = 15; s.mask < s.nblocks * 2; s.mask = s.mask * 2 + 1)
+        ;
+    s.head = malloc((s.mask + 1) * sizeof *s.head);
+    s.next = malloc((s.nblocks + 1) * sizeof *s.next);
+    cap = s.block_size * 16 > (1 << 20) ? s.block_size * 16 : 1 << 20;
+    buf = malloc(cap);
+    if (! s.head || ! s.next || ! buf)
+        goto done;
+    for (i = 0; i <= s.mask; i++)
+        s.head[i] = s.nblocks;
+    for (i = s.nblocks; i--; ) {
+        if (i == s.nblocks - 1 && s.last_len < s.block_size)
+            continue;
+        k = sig_slot(&s, sig_weak(&s, i));
+        s.next[i] = s.head[k];
+        s.head[k] = i;
+    }
+    sph_jh_fixed_init(&fx, s.block_size, 256);
+    lanes = sph_jh_multi_lanes();
+
+    put(&w.out, "JHRD", 4);
+    put_be(&w.out, s.block_size, 4);
+
+    for (;;) {
+        /* keep the window and the lookahead blocks in the buffer */
+        if (pos + lanes * s.block_size + 1 > fill && ! eof) {
+            emit_literal(&w, buf + lit, pos - lit);
+            memmove(buf, buf + pos, fill - pos);
+            fill -= pos;
+            lit = pos = 0;
+            r = read_full(rd, ctx, buf + fill, cap - fill);
+            if (r < 0)
+                goto done;
+            if ((size_t)r < cap - fill)
+                eof = 1;
+            fill += r;
+        }
+        if (fill - pos < s.block_size)
+            break;
+        if (! have_weak) {
+            weak_sums(buf + pos, s.block_size, &a, &b);
+            have_weak = 1;
+        }
+
+        /*
+         * A weak match at pos is checked with JH, together with the
+         * following blocks whose weak checksums also appear in the
+         * signature, since matches tend to come in runs.
+         */
+        matched = 0;
+        if (sig_has_weak(&s, WEAK(a, b))) {
+            cand[0] = buf + pos;
+            for (k = 1; k < lanes && pos + (k + 1) * s.block_size <= fill;
+                 k++) {
+                weak_sums(buf + pos + k * s.block_size, s.block_size,
+                    &ta, &tb);
+                if (! sig_has_weak(&s, WEAK(ta, tb)))
+                    break;
+                cand[k] = buf + pos + k * s.block_size;
+            }
+            sph_jh_fixed_many(&fx, cand, k, strong);
+            for (i = 0; i < k; i++) {
+                if (i)
+                    weak_sums(cand[i], s.block_size, &a, &b);
+                weak = WEAK(a, b);
+                blk = sig_find(&s, weak, strong + i * 32);
+                if (blk == s.nblocks)
+                    break;
+                emit_literal(&w, buf + lit, pos - lit);
+                emit_copy(&w, blk);
+                pos += s.block_size;
+                lit = pos;
+                matched = 1;
+            }
+        }
+        if (matched) {
+            have_weak = 0;
+            continue;
+        }
+
+        /* roll the window by one byte */
+        if (pos + s.block_size >= fill)
+            break;
+        ta = buf[pos];
+        tb = buf[pos + s.block_size];
+        a = (a - ta + tb) & 0xffff;
+        b = (b - (unsigned)(s.block_size * ta) + a) & 0xffff;
+        pos++;
+    }
+
+    /* a short last basis block can only match the end of the file */
+    if (s.nblocks && s.last_len < s.block_size && fill - lit >= s.last_len) {
+        const unsigned char *t = buf + fill - s.last_len;
+        weak_sums(t, s.last_len, &ta, &tb);
+        if (WEAK(ta, tb) == sig_weak(&s, s.nblocks - 1)) {
+            sph_jh_init_size(&sc, 256);
+            sph_jh(&sc, t, s.last_len);
+            sph_jh_close_size(&sc, strong, 256);
+            if (! memcmp(strong, sig_strong(&s, s.nblocks - 1),
+                    s.strong_len)) {
+                emit_literal(&w, buf + lit, t - (buf + lit));
+                emit_copy(&w, s.nblocks - 1);
+                lit = fill;
+            }
+        }
+    }
+    emit_literal(&w, buf + lit, fill - lit);
+    flush_copy(&w);
+    if (w.out.failed)
+        goto done;
+    *delta = w.out.p;
+    w.out.p = NULL;
+    ret = (long)w.out.len;
+
+done:
+    free(w.out.p);
+    free(s.head);
+    free(s.next);
+    free(buf);
+    return ret;
+}
@@ -0,0 +1,45 @@
+/*
+ * rsync-style delta encoding with JH as the strong checksum.
+ *
+ * A signature describes a basis file by block: for each block of
+ * block_size bytes (the last one may be shorter), rsync's rolling weak
+ * checksum and the first strong_len bytes of its JH-256 digest. A delta
+ * describes a new file as copies of basis blocks and literal data; it
+ * is found by sliding a window over the new file, rolling the weak
+ * checksum one byte at a time, and confirming weak matches with JH.
+ *
+ * Signature: "JHRS", a version byte (1), strong_len, two zero bytes,
+ * block_size (32-bit), the basis length (64-bit), then the weak (32-bit)
+ * and strong checksums of each block. Delta: "JHRD", block_size (32-bit),
+ * then records, either 'C', a first block (64-bit) and a block count
+ * (32-bit), or 'L', a length (32-bit) and that many bytes of data. All
+ * integers are big-endian.
+ */
+
+#ifndef JH_DELTA_H__
+#define JH_DELTA_H__
+
+#include <stddef.h>
+#include "pieces.h"
+
+#define JH_DELTA_BAD_SIGNATURE  (-2)
+
+/*
+ * Reads the basis and writes its signature to a buffer allocated with
+ * malloc(), which the caller frees. strong_len is 1 to 32. Returns the
+ * signature length, or -1 on a read error, bad parameters or allocation
+ * failure.
+ */
+long jh_delta_signature(jh_pieces_reader rd, void *ctx, size_t block_size,
+    unsigned strong_len, unsigned char **sig);
+
+/*
+ * Reads the new file and writes its delta against the signature to a
+ * buffer allocated with malloc(), which the caller frees. Returns the
+ * delta length, -1 on a read error or allocation failure, or
+ * JH_DELTA_BAD_SIGNATURE.
+ */
+long jh_delta_encode(jh_pieces_reader rd, void *ctx,
+    const unsigned char *sig, size_t sig_len, unsigned char **delta);
+
+#endif
@@ -0,0 +1,175 @@
+/*
+ * Hash_DRBG over JH-512; see drbg.h.
+ */
+
+#include <string.h>
+
+#include "drbg.h"
+
+/* dst = (dst + src) mod 2^888, with src right-aligned to dst */
+static void
+add_be (unsigned char *dst, const unsigned char *src, size_t src_len) {
+    unsigned carry = 0;
+    size_t i = JH_DRBG_SEEDLEN, j = src_len;
+
+    while (i--) {
+        carry += dst[i];
+        if (j)
+            carry += src[--j];
+        dst[i] = (unsigned char)carry;
+        carry >>= 8;
+    }
+}
+
+/* Hash_df(prefix || a || b || c, seedlen) */
+static void
+hash_df (unsigned char *out, unsigned char prefix, int use_prefix,
+         const void *a, size_t a_len, const void *b, size_t b_len,
+         const void *c, size_t c_len) {
+    unsigned char head[6];
+    unsigned char digest[JH_DRBG_OUTLEN];
+    sph_jh_context sc;
+    size_t done, n;
+    unsigned char counter;
+
+    /* no_of_bits_to_return, as a 32-bit big-endian integer */
+    head[1] = 0;
+    head[2] = 0;
+    head[3] = (unsigned char)((JH_DRBG_SEEDLEN * 8) >> 8);
+    head[4] = (unsigned char)(JH_DRBG_SEEDLEN * 8);
+    head[5] = prefix;
+    for (done = 0, counter = 1; done < JH_DRBG_SEEDLEN; counter++) {
+        head[0] = counter;
+        sph_jh512_init(&sc);
+        sph_jh(&sc, head, use_prefix ? 6 : 5);
+        sph_jh(&sc, a, a_len);
+        sph_jh(&sc, b, b_len);
+        sph_jh(&sc, c, c_len);
+        sph_jh512_close(&sc, digest);
+        n = JH_DRBG_SEEDLEN - done;
+        if (n > JH_DRBG_OUTLEN)
+            n = JH_DRBG_OUTLEN;
+        memcpy(out + done, digest, n);
+        done += n;
+    }
+}
+
+/* Hash(prefix || V || add) */
+static void
+hash_v (unsigned char *out, unsigned char prefix, const unsigned char *V,
+        const void *add, size_t add_len) {
+    sph_jh_context sc;
+    sph_jh512_init(&sc);
+    sph_jh(&sc, &prefix, 1);
+    sph_jh(&sc, V, JH_DRBG_SEEDLEN);
+    sph_jh(&sc, add, add_len);
+    sph_jh512_close(&sc, out);
+}
+
+static void
+derive_c (jh_drbg *d) {
+    hash_df(d->C, 0x00, 1, d->V, JH_DRBG_SEEDLEN, "", 0, "", 0);
+    d->reseed_counter = 1;
+    d->avail = 0;
+}
+
+void
+jh_drbg_instantiate (jh_drbg *d, const void *entropy, size_t entropy_len,
+                     const void *nonce, size_t nonce_len,
+                     const void *pers, size_t pers_len) {
+    hash_df(d->V, 0, 0, entropy, entropy_len, nonce, nonce_len,
+        pers, pers_len);
+    derive_c(d);
+}
+
+void
+jh_drbg_reseed (jh_drbg *d, const void *entropy, size_t entropy_len,
+                const void *add, size_t add_len) {
+    unsigned char V[JH_DRBG_SEEDLEN];
+    memcpy(V, d->V, sizeof V);
+    hash_df(d->V, 0x01, 1, V, sizeof V, entropy, entropy_len, add, add_len);
+    derive_c(d);
+}
+
+/* Output blocks hashed per sph_jh_multi_close() call in Hashgen. */
+#define HASHGEN_CHUNK 32
+
+int
+jh_drbg_generate (jh_drbg *d, void *out, size_t len,
+                  const void *add, size_t add_len) {
+    unsigned char data[HASHGEN_CHUNK][JH_DRBG_SEEDLEN];
+    unsigned char cur[JH_DRBG_SEEDLEN];
+    unsigned char block[HASHGEN_CHUNK * JH_DRBG_OUTLEN];
+    const sph_jh_context *starts[HASHGEN_CHUNK];
+    const void *ptrs[HASHGEN_CHUNK];
+    size_t lens[HASHGEN_CHUNK];
+    unsigned char w[JH_DRBG_OUTLEN];
+    unsigned char rc[8];
+    unsigned char *p = out;
+    sph_jh_context iv;
+    size_t i, n;
+    static const unsigned char one = 1;
+
+    if (len > JH_DRBG_MAX_REQUEST
+        || d->reseed_counter > JH_DRBG_RESEED_INTERVAL)
+        return -1;
+    if (add_len) {
+        hash_v(w, 0x02, d->V, add, add_len);
+        add_be(d->V, w, sizeof w);
+    }
+
+    /* Hashgen: output block i is Hash(V + i). */
+    sph_jh512_init(&iv);
+    for (i = 0; i < HASHGEN_CHUNK; i++) {
+        starts[i] = &iv;
+        ptrs[i] = data[i];
+        lens[i] = JH_DRBG_SEEDLEN;
+    }
+    memcpy(cur, d->V, JH_DRBG_SEEDLEN);
+    while (len) {
+        n = (len + JH_DRBG_OUTLEN - 1) / JH_DRBG_OUTLEN;
+        if (n > HASHGEN_CHUNK)
+            n = HASHGEN_CHUNK;
+        for (i = 0; i < n; i++) {
+            memcpy(data[i], cur, JH_DRBG_SEEDLEN);
+            add_be(cur, &one, 1);
+        }
+        sph_jh_multi_close(starts, ptrs, lens, n, block, 512);
+        n *= JH_DRBG_OUTLEN;
+        if (n > len)
+            n = len;
+        memcpy(p, block, n);
+        p += n;
+        len -= n;
+    }
+
+    /* V = V + Hash(0x03 || V) + C + reseed_counter */
+    hash_v(w, 0x03, d->V, "", 0);
+    add_be(d->V, w, sizeof w);
+    add_be(d->V, d->C, JH_DRBG_SEEDLEN);
+    for (i = 0; i < 8; i++)
+        rc[i] = (unsigned char)(d->reseed_counter >> (56 - 8 * i));
+    add_be(d->V, rc, sizeof rc);
+    d->reseed_counter++;
+    return 0;
+}
+
+int
+jh_drbg_read (jh_drbg *d, void *out, size_t len) {
+    unsigned char *p = out;
+    size_t n;
+
+    while (len) {
+        if (! d->avail) {
+            if (jh_drbg_generate(d, d->buf, JH_DRBG_BUFFER, "", 0) < 0)
+                return -1;
+            d->avail = JH_DRBG_BUFFER;
+        }
+        n = len < d->avail ? len : d->avail;
+        memcpy(p, d->buf + JH_DRBG_BUFFER - d->avail, n);
+        d->avail -= n;
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
@@ -0,0 +1,52 @@
+/*
+ * Hash_DRBG (NIST SP 800-90A) with JH-512 as the hash function.
+ *
+ * JH-512 takes the parameters of SHA-512: a 888-bit seed length and a
+ * 256-bit security strength. The hashes of V, V + 1, ... that make up
+ * one Generate request are independent, so they are computed together
+ * in the vector lanes; jh_drbg_read() serves small reads from a buffer
+ * refilled one large Generate request at a time.
+ */
+
+#ifndef JH_DRBG_H__
+#define JH_DRBG_H__
+
+#include <stddef.h>
+#include "sph_jh.h"
+
+#define JH_DRBG_SEEDLEN 111
+#define JH_DRBG_OUTLEN 64
+#define JH_DRBG_MAX_REQUEST 65536
+#define JH_DRBG_RESEED_INTERVAL ((sph_u64)1 << 48)
+#define JH_DRBG_BUFFER 2048
+
+typedef struct {
+    unsigned char V[JH_DRBG_SEEDLEN];
+    unsigned char C[JH_DRBG_SEEDLEN];
+    sph_u64 reseed_counter;
+    size_t avail;
+    unsigned char buf[JH_DRBG_BUFFER];
+} jh_drbg;
+
+void jh_drbg_instantiate(jh_drbg *d, const void *entropy, size_t entropy_len,
+    const void *nonce, size_t nonce_len, const void *pers, size_t pers_len);
+
+/* Also discards any buffered output. */
+void jh_drbg_reseed(jh_drbg *d, const void *entropy, size_t entropy_len,
+    const void *add, size_t add_len);
+
+/*
+ * One Generate request of len bytes (at most JH_DRBG_MAX_REQUEST).
+ * Returns -1 if the request is too large or a reseed is required.
+ */
+int jh_drbg_generate(jh_drbg *d, void *out, size_t len,
+    const void *add, size_t add_len);
+
+/*
+ * Buffered output: the stream is the concatenation of successive
+ * JH_DRBG_BUFFER-byte Generate requests without additional input.
+ * Returns -1 if a reseed is required.
+ */
+int jh_drbg_read(jh_drbg *d, void *out, size_t len);
+
+#endif
@@ -0,0 +1,201 @@
+/*
+ * Hex and Base64 encoders for digest output.
+ *
+ * The portable versions are simple table loops. On x86 the SSSE3 and
+ * AVX2 versions encode 16/32 input bytes (hex) or 12/24 input bytes
+ * (Base64) per iteration with byte shuffles, and hand any remainder to
+ * the narrower version.
+ */
+
+#include "cpu.h"
+
+static const char hex_chars[] = "0123456789abcdef";
+static const char b64_chars[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static int
+hex_encode_scalar (char *dest, const unsigned char *src, int len) {
+    char *p = dest;
+    const unsigned char *s = src;
+    for (; len--; s++) {
+        *p++ = hex_chars[s[0] >> 4];
+        *p++ = hex_chars[s[0] & 0x0f];
+    }
+    return (int)(p - dest);
+}
+
+static int
+base64_encode_scalar (char *dest, const unsigned char *src, int len,
+                      int pad) {
+    char *p = dest;
+    const unsigned char *s = src;
+    const unsigned char *end = src + len - 2;
+
+    for (; s < end; s += 3) {
+        *p++ = b64_chars[s[0] >> 2];
+        *p++ = b64_chars[((s[0] & 3) << 4) + (s[1] >> 4)];
+        *p++ = b64_chars[((s[1] & 0xf) << 2) + (s[2] >> 6)];
+        *p++ = b64_chars[s[2] & 0x3f];
+    }
+    switch (len % 3) {
+    case 1:
+        *p++ = b64_chars[s[0] >> 2];
+        *p++ = b64_chars[(s[0] & 3) << 4];
+        if (pad) {
+            *p++ = '=';
+            *p++ = '=';
+        }
+        break;
+    case 2:
+        *p++ = b64_chars[s[0] >> 2];
+        *p++ = b64_chars[((s[0] & 3) << 4) + (s[1] >> 4)];
+        *p++ = b64_chars[((s[1] & 0xf) << 2)];
+        if (pad)
+            *p++ = '=';
+        break;
+    }
+    return (int)(p - dest);
+}
+
+#if JH_X86_DISPATCH
+
+JH_TARGET("ssse3") static int
+hex_encode_ssse3 (char *dest, const unsigned char *src, int len) {
+    const __m128i lut = _mm_setr_epi8('0', '1', '2', '3', '4', '5', '6',
+        '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f');
+    const __m128i mask = _mm_set1_epi8(0x0f);
+    char *p = dest;
+
+    for (; len >= 16; len -= 16, src += 16, p += 32) {
+        __m128i v  = _mm_loadu_si128((const __m128i *)src);
+        __m128i hi = _mm_shuffle_epi8(lut,
+            _mm_and_si128(_mm_srli_epi16(v, 4), mask));
+        __m128i lo = _mm_shuffle_epi8(lut, _mm_and_si128(v, mask));
+        _mm_storeu_si128((__m128i *)p, _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128((__m128i *)(p + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+    return (int)(p - dest) + hex_encode_scalar(p, src, len);
+}
+
+JH_TARGET("avx2") static int
+hex_encode_avx2 (char *dest, const unsigned char *src, int len) {
+    const __m256i lut = _mm256_setr_epi8('0', '1', '2', '3', '4', '5',
+        '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f', '0', '1', '2',
+        '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f');
+    const __m256i mask = _mm256_set1_epi8(0x0f);
+    char *p = dest;
+
+    for (; len >= 32; len -= 32, src += 32, p += 64) {
+        __m256i v  = _mm256_loadu_si256((const __m256i *)src);
+        __m256i hi = _mm256_shuffle_epi8(lut,
+            _mm256_and_si256(_mm256_srli_epi16(v, 4), mask));
+        __m256i lo = _mm256_shuffle_epi8(lut, _mm256_and_si256(v, mask));
+        __m256i a  = _mm256_unpacklo_epi8(hi, lo);
+        __m256i b  = _mm256_unpackhi_epi8(hi, lo);
+        /* unpack works within 128-bit lanes; put the halves in order */
+        _mm256_storeu_si256((__m256i *)p,
+            _mm256_permute2x128_si256(a, b, 0x20));
+        _mm256_storeu_si256((__m256i *)(p + 32),
+            _mm256_permute2x128_si256(a, b, 0x31));
+    }
+    return (int)(p - dest) + hex_encode_ssse3(p, src, len);
+}
+
+/*
+ * Base64 encoding of 12 bytes per 128-bit lane, after W. Mula and
+ * D. Lemire, "Faster Base64 Encoding and Decoding using AVX2
+ * Instructions": the bytes are shuffled so that every 32-bit word holds
+ * one 3-byte group, the four 6-bit indices are isolated with two
+ * multiplies, and a 16-entry offset table maps indices to characters.
+ */
+
+JH_TARGET("ssse3") static int
+base64_encode_ssse3 (char *dest, const unsigned char *src, int len,
+                     int pad) {
+    const __m128i shuf = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5,
+        3, 4, 1, 2, 0, 1);
+    const __m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    char *p = dest;
+
+    /* Each iteration loads 16 bytes but only consumes 12. */
+    for (; len >= 16; len -= 12, src += 12, p += 16) {
+        __m128i in = _mm_shuffle_epi8(
+            _mm_loadu_si128((const __m128i *)src), shuf);
+        __m128i t0 = _mm_mulhi_epu16(
+            _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00)),
+            _mm_set1_epi32(0x04000040));
+        __m128i t1 = _mm_mullo_epi16(
+            _mm_and_si128(in, _mm_set1_epi32(0x003f03f0)),
+            _mm_set1_epi32(0x01000010));
+        __m128i idx = _mm_or_si128(t0, t1);
+        __m128i r = _mm_subs_epu8(idx, _mm_set1_epi8(51));
+        r = _mm_or_si128(r, _mm_and_si128(
+            _mm_cmpgt_epi8(_mm_set1_epi8(26), idx), _mm_set1_epi8(13)));
+        r = _mm_add_epi8(_mm_shuffle_epi8(offsets, r), idx);
+        _mm_storeu_si128((__m128i *)p, r);
+    }
+    return (int)(p - dest) + base64_encode_scalar(p, src, len, pad);
+}
+
+JH_TARGET("avx2") static int
+base64_encode_avx2 (char *dest, const unsigned char *src, int len,
+                    int pad) {
+    const __m256i shuf = _mm256_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5,
+        3, 4, 1, 2, 0, 1, 10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+    const __m256i offsets = _mm256_setr_epi8('a' - 26, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+        'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+        '/' - 63, 'A', 0, 0);
+    char *p = dest;
+
+    /* Lane 0 takes src[0..11] and lane 1 takes src[12..23]. */
+    for (; len >= 28; len -= 24, src += 24, p += 32) {
+        __m256i in = _mm256_shuffle_epi8(_mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)src)),
+            _mm_loadu_si128((const __m128i *)(src + 12)), 1), shuf);
+        __m256i t0 = _mm256_mulhi_epu16(
+            _mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00)),
+            _mm256_set1_epi32(0x04000040));
+        __m256i t1 = _mm256_mullo_epi16(
+            _mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0)),
+            _mm256_set1_epi32(0x01000010));
+        __m256i idx = _mm256_or_si256(t0, t1);
+        __m256i r = _mm256_subs_epu8(idx, _mm256_set1_epi8(51));
+        r = _mm256_or_si256(r, _mm256_and_si256(
+            _mm256_cmpgt_epi8(_mm256_set1_epi8(26), idx),
+            _mm256_set1_epi8(13)));
+        r = _mm256_add_epi8(_mm256_shuffle_epi8(offsets, r), idx);
+        _mm256_storeu_si256((__m256i *)p, r);
+    }
+    return (int)(p - dest) + base64_encode_ssse3(p, src, len, pad);
+}
+
+#endif
+
+static int
+hex_encode (char *dest, const unsigned char *src, int len) {
+#if JH_X86_DISPATCH
+    int cpu = jh_cpu_features();
+    if (cpu & JH_CPU_AVX2)
+        return hex_encode_avx2(dest, src, len);
+    if (cpu & JH_CPU_SSSE3)
+        return hex_encode_ssse3(dest, src, len);
+#endif
+    return hex_encode_scalar(dest, src, len);
+}
+
+static int
+base64_encode (char *dest, const unsigned char *src, int len, int pad) {
+#if JH_X86_DISPATCH
+    int cpu = jh_cpu_features();
+    if (cpu & JH_CPU_AVX2)
+        return base64_encode_avx2(dest, src, len, pad);
+    if (cpu & JH_CPU_SSSE3)
+        return base64_encode_ssse3(dest, src, len, pad);
+#endif
+    return base64_encode_scalar(dest, src, len, pad);
+}
@@ -0,0 +1,126 @@
+/*
+ * HMAC (RFC 2104) over JH; see hmac.h.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "hmac.h"
+
+int
+jh_hmac_init (jh_hmac_context *hc, unsigned out_size,
+              const void *key, size_t key_len) {
+    unsigned char block[JH_HMAC_BLOCK];
+    size_t i;
+
+    if (sph_jh_init_size(&hc->inner, out_size) < 0)
+        return -1;
+    hc->out_size = out_size;
+
+    memset(block, 0, sizeof block);
+    if (key_len > JH_HMAC_BLOCK) {
+        sph_jh(&hc->inner, key, key_len);
+        sph_jh_close_size(&hc->inner, block, out_size);
+    }
+    else {
+        memcpy(block, key, key_len);
+    }
+    hc->outer = hc->inner;
+
+    for (i = 0; i < JH_HMAC_BLOCK; i++)
+        block[i] ^= 0x36;
+    sph_jh(&hc->inner, block, JH_HMAC_BLOCK);
+    for (i = 0; i < JH_HMAC_BLOCK; i++)
+        block[i] ^= 0x36 ^ 0x5c;
+    sph_jh(&hc->outer, block, JH_HMAC_BLOCK);
+
+    memset(block, 0, sizeof block);
+    hc->ctx = hc->inner;
+    return 0;
+}
+
+void
+jh_hmac_reset (jh_hmac_context *hc) {
+    hc->ctx = hc->inner;
+}
+
+void
+jh_hmac_update (jh_hmac_context *hc, const void *data, size_t len) {
+    sph_jh(&hc->ctx, data, len);
+}
+
+void
+jh_hmac_finish (const jh_hmac_context *hc, const void *inner, void *dst) {
+    sph_jh_context sc = hc->outer;
+    sph_jh(&sc, inner, hc->out_size >> 3);
+    sph_jh_close_size(&sc, dst, hc->out_size);
+}
+
+void
+jh_hmac_close (jh_hmac_context *hc, void *dst) {
+    unsigned char inner[64];
+    sph_jh_close_size(&hc->ctx, inner, hc->out_size);
+    jh_hmac_finish(hc, inner, dst);
+    hc->ctx = hc->inner;
+}
+
+void
+jh_hmac_mac (const jh_hmac_context *hc, const void *data, size_t len,
+             void *dst) {
+    unsigned char inner[64];
+    sph_jh_context sc = hc->inner;
+    sph_jh(&sc, data, len);
+    sph_jh_close_size(&sc, inner, hc->out_size);
+    jh_hmac_finish(hc, inner, dst);
+}
+
+int
+jh_hmac_batch_init (jh_hmac_batch *b, size_t n) {
+    b->n = n;
+    if (! n)
+        n = 1;
+    b->starts = malloc(n * sizeof *b->starts);
+    b->inner_ptrs = malloc(n * sizeof *b->inner_ptrs);
+    b->inner_lens = malloc(n * sizeof *b->inner_lens);
+    b->inner = malloc(n * 64);
+    if (! b->starts || ! b->inner_ptrs || ! b->inner_lens || ! b->inner) {
+        jh_hmac_batch_free(b);
+        return -1;
+    }
+    return 0;
+}
+
+void
+jh_hmac_batch_free (jh_hmac_batch *b) {
+    free(b->starts);
+    free(b->inner_ptrs);
+    free(b->inner_lens);
+    free(b->inner);
+    b->starts = NULL;
+    b->inner_ptrs = NULL;
+    b->inner_lens = NULL;
+    b->inner = NULL;
+}
+
+void
+jh_hmac_batch_mac (jh_hmac_batch *b, const jh_hmac_context *const *hc,
+                   const void *const *data, const size_t *len, size_t n,
+                   void *dst) {
+    unsigned out_size;
+    size_t i, out_len;
+
+    if (! n)
+        return;
+    out_size = hc[0]->out_size;
+    out_len = out_size >> 3;
+    for (i = 0; i < n; i++) {
+        b->starts[i] = &hc[i]->inner;
+        b->inner_ptrs[i] = b->inner + i * out_len;
+        b->inner_lens[i] = out_len;
+    }
+    sph_jh_multi_close(b->starts, data, len, n, b->inner, out_size);
+    for (i = 0; i < n; i++)
+        b->starts[i] = &hc[i]->outer;
+    sph_jh_multi_close(b->starts, b->inner_ptrs, b->inner_lens, n, dst,
+        out_size);
+}
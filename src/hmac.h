@@ -0,0 +1,70 @@
+/*
+ * HMAC (RFC 2104) over JH.
+ *
+ * The key is absorbed once: the contexts after the first block,
+ * (key ^ ipad) and (key ^ opad), are kept as midstates, and each message
+ * starts from a copy of them, so a MAC costs no more compressions than
+ * hashing the message and the inner digest.
+ */
+
+#ifndef JH_HMAC_H__
+#define JH_HMAC_H__
+
+#include <stddef.h>
+#include "sph_jh.h"
+
+#define JH_HMAC_BLOCK 64
+
+typedef struct {
+    sph_jh_context inner;   /* after key ^ ipad */
+    sph_jh_context outer;   /* after key ^ opad */
+    sph_jh_context ctx;     /* running inner hash */
+    unsigned out_size;      /* in bits */
+} jh_hmac_context;
+
+/* Returns -1 if out_size is not 224, 256, 384 or 512. */
+int jh_hmac_init(jh_hmac_context *hc, unsigned out_size,
+    const void *key, size_t key_len);
+
+void jh_hmac_reset(jh_hmac_context *hc);
+
+void jh_hmac_update(jh_hmac_context *hc, const void *data, size_t len);
+
+/* Writes out_size / 8 bytes and resets the running hash. */
+void jh_hmac_close(jh_hmac_context *hc, void *dst);
+
+/* MAC of one message from the midstates; the running hash is unused. */
+void jh_hmac_mac(const jh_hmac_context *hc, const void *data, size_t len,
+    void *dst);
+
+/* Outer hash of an inner digest, starting from the midstate. */
+void jh_hmac_finish(const jh_hmac_context *hc, const void *inner,
+    void *dst);
+
+/*
+ * Work space for MACs of many messages at once: the inner and then the
+ * outer hashes of all messages go through sph_jh_multi_close().
+ */
+typedef struct {
+    size_t n;
+    const sph_jh_context **starts;
+    const void **inner_ptrs;
+    size_t *inner_lens;
+    unsigned char *inner;
+} jh_hmac_batch;
+
+/* Allocates room for up to n messages; returns -1 on failure. */
+int jh_hmac_batch_init(jh_hmac_batch *b, size_t n);
+
+void jh_hmac_batch_free(jh_hmac_batch *b);
+
+/*
+ * MACs of n messages, where message i uses the key of hc[i]; all the
+ * contexts must have the same output size. The MACs are written
+ * consecutively to dst, which may overlap the messages: these are all
+ * read before any MAC is written.
+ */
+void jh_hmac_batch_mac(jh_hmac_batch *b, const jh_hmac_context *const *hc,
+    const void *const *data, const size_t *len, size_t n, void *dst);
+
+#endif
@@ -34,6 +34,8 @@
 #include <string.h>
 
 #include "sph_jh.h"
+#include "stats.h"
+#include "probes.h"
 
 #if SPH_SMALL_FOOTPRINT && !defined SPH_SMALL_FOOTPRINT_JH
 #define SPH_SMALL_FOOTPRINT_JH   1
@@ -79,6 +81,7 @@
                     | ((SPH_C64(x) << 40) & SPH_C64(0x00FF000000000000)) \
                     | ((SPH_C64(x) << 56) & SPH_C64(0xFF00000000000000)))
 #define dec64e_aligned   sph_dec64le_aligned
+#define dec64e           sph_dec64le
 #define enc64e           sph_enc64le
 #endif
 
@@ -90,6 +93,7 @@
 #if SPH_64
 #define C64e(x)     SPH_C64(x)
 #define dec64e_aligned   sph_dec64be_aligned
+#define dec64e           sph_dec64be
 #define enc64e           sph_enc64be
 #endif
 
@@ -907,6 +911,7 @@ jh_core(sph_jh_context *sc, const void *data, size_t len)
 	size_t ptr;
 	DECL_STATE
 
+	JH_STAT_ADD(JH_STAT_BUFFERED, len);
 	buf = sc->buf;
 	ptr = sc->ptr;
 	if (len < (sizeof sc->buf) - ptr) {
@@ -916,6 +921,7 @@ jh_core(sph_jh_context *sc, const void *data, size_t len)
 		return;
 	}
 
+	JH_PROBE2(compress, sc, (ptr + len) >> 6);
 	READ_STATE(sc);
 	while (len > 0) {
 		size_t clen;
@@ -928,6 +934,8 @@ jh_core(sph_jh_context *sc, const void *data, size_t len)
 		data = (const unsigned char *)data + clen;
 		len -= clen;
 		if (ptr == sizeof sc->buf) {
+			JH_STAT_ADD(JH_STAT_KERNEL_CORE, 1);
+			JH_STAT_ADD(JH_STAT_BLOCKS, 1);
 			INPUT_BUF1;
 			E8;
 			INPUT_BUF2;
@@ -992,6 +1000,8 @@ jh_close(sph_jh_context *sc, unsigned ub, unsigned n,
 #endif
 	memcpy(dst, buf + ((16 - out_size_w32) << 2), out_size_w32 << 2);
 	jh_init(sc, iv);
+	JH_STAT_ADD(JH_STAT_FINALS, 1);
+	JH_PROBE2(final, sc, out_size_w32 << 5);
 }
 
 /* see sph_jh.h */
@@ -1005,6 +1015,7 @@ sph_jh224_init(void *cc)
 void
 sph_jh224(void *cc, const void *data, size_t len)
 {
+	JH_STAT_ADD(JH_STAT_BYTES, len);
 	jh_core(cc, data, len);
 }
 
@@ -1033,6 +1044,7 @@ sph_jh256_init(void *cc)
 void
 sph_jh256(void *cc, const void *data, size_t len)
 {
+	JH_STAT_ADD(JH_STAT_BYTES, len);
 	jh_core(cc, data, len);
 }
 
@@ -1061,6 +1073,7 @@ sph_jh384_init(void *cc)
 void
 sph_jh384(void *cc, const void *data, size_t len)
 {
+	JH_STAT_ADD(JH_STAT_BYTES, len);
 	jh_core(cc, data, len);
 }
 
@@ -1089,6 +1102,7 @@ sph_jh512_init(void *cc)
 void
 sph_jh512(void *cc, const void *data, size_t len)
 {
+	JH_STAT_ADD(JH_STAT_BYTES, len);
 	jh_core(cc, data, len);
 }
 
@@ -1105,3 +1119,869 @@ sph_jh512_addbits_and_close(void *cc, unsigned ub, unsigned n, void *dst)
 {
 	jh_close(cc, ub, n, dst, 16, IV512);
 }
+
+/* see sph_jh.h */
+size_t
+sph_jh_export(const void *cc, void *dst)
+{
+	const sph_jh_context *sc;
+	unsigned char *out;
+	size_t u;
+
+	sc = cc;
+	out = dst;
+#if SPH_JH_64
+	for (u = 0; u < 16; u ++)
+		enc64e(out + (u << 3), sc->H.wide[u]);
+#else
+	for (u = 0; u < 32; u ++)
+		enc32e(out + (u << 2), sc->H.narrow[u]);
+#endif
+#if SPH_64
+	sph_enc64be(out + 128, sc->block_count);
+#else
+	sph_enc32be(out + 128, sc->block_count_high);
+	sph_enc32be(out + 132, sc->block_count_low);
+#endif
+	out[136] = (unsigned char)sc->ptr;
+	memcpy(out + 137, sc->buf, sc->ptr);
+	return 137 + sc->ptr;
+}
+
+/* see sph_jh.h */
+size_t
+sph_jh_import(void *cc, const void *src, size_t len)
+{
+	sph_jh_context *sc;
+	const unsigned char *in;
+	union {
+		unsigned char bytes[128];
+#if SPH_64
+		sph_u64 align;
+#endif
+		sph_u32 align32;
+	} h;
+	size_t ptr, u;
+
+	sc = cc;
+	in = src;
+	if (len < 137)
+		return 0;
+	ptr = in[136];
+	if (ptr >= sizeof sc->buf || len < 137 + ptr)
+		return 0;
+	memcpy(h.bytes, in, sizeof h.bytes);
+#if SPH_JH_64
+	for (u = 0; u < 16; u ++)
+		sc->H.wide[u] = dec64e_aligned(h.bytes + (u << 3));
+#else
+	for (u = 0; u < 32; u ++)
+		sc->H.narrow[u] = dec32e_aligned(h.bytes + (u << 2));
+#endif
+#if SPH_64
+	sc->block_count = sph_dec64be(in + 128);
+#else
+	sc->block_count_high = sph_dec32be(in + 128);
+	sc->block_count_low = sph_dec32be(in + 132);
+#endif
+	sc->ptr = ptr;
+	memcpy(sc->buf, in + 137, ptr);
+	return 137 + ptr;
+}
+
+/* see sph_jh.h */
+void
+sph_jh(void *cc, const void *data, size_t len)
+{
+	JH_STAT_ADD(JH_STAT_BYTES, len);
+	jh_core(cc, data, len);
+}
+
+/* see sph_jh.h */
+int
+sph_jh_init_size(void *cc, unsigned out_size)
+{
+	switch (out_size) {
+	case 224:
+		jh_init(cc, IV224);
+		break;
+	case 256:
+		jh_init(cc, IV256);
+		break;
+	case 384:
+		jh_init(cc, IV384);
+		break;
+	case 512:
+		jh_init(cc, IV512);
+		break;
+	default:
+		return -1;
+	}
+	return 0;
+}
+
+/* see sph_jh.h */
+void
+sph_jh_close_size(void *cc, void *dst, unsigned out_size)
+{
+	switch (out_size) {
+	case 224:
+		jh_close(cc, 0, 0, dst, 7, IV224);
+		break;
+	case 256:
+		jh_close(cc, 0, 0, dst, 8, IV256);
+		break;
+	case 384:
+		jh_close(cc, 0, 0, dst, 12, IV384);
+		break;
+	case 512:
+		jh_close(cc, 0, 0, dst, 16, IV512);
+		break;
+	}
+}
+
+/* see sph_jh.h */
+int
+sph_jh_hash(const void *data, size_t len, void *dst, unsigned out_size)
+{
+	sph_jh_context sc;
+
+	if (sph_jh_init_size(&sc, out_size) < 0)
+		return -1;
+	sph_jh(&sc, data, len);
+	sph_jh_close_size(&sc, dst, out_size);
+	return 0;
+}
+
+/*
+ * Multi-lane hashing: independent messages are processed side by side,
+ * with the corresponding state words of two or four messages held in
+ * the lanes of one vector. All the E8 operations work lane-wise, so the
+ * macros above are reused as they are on GCC vector types; only the two
+ * which declare a temporary need a type-generic version.
+ */
+
+#include "cpu.h"
+
+#if SPH_JH_64 && !defined JH_NO_SIMD \
+	&& (defined __clang__ || __GNUC__ >= 5)
+#define SPH_JH_LANES   1
+#else
+#define SPH_JH_LANES   0
+#endif
+
+#if SPH_JH_LANES
+
+#undef Wz
+#define Wz(x, c, n)   do { \
+		__typeof__(x ## h) t = (x ## h & (c)) << (n); \
+		x ## h = ((x ## h >> (n)) & (c)) | t; \
+		t = (x ## l & (c)) << (n); \
+		x ## l = ((x ## l >> (n)) & (c)) | t; \
+	} while (0)
+
+#undef W6
+#define W6(x)   do { \
+		__typeof__(x ## h) t = x ## h; \
+		x ## h = x ## l; \
+		x ## l = t; \
+	} while (0)
+
+#define LANE_READ(k)   do { \
+		const sph_u64 *s = H[k]; \
+		const unsigned char *b = blk[k]; \
+		h0h[k] = s[ 0]; h0l[k] = s[ 1]; h1h[k] = s[ 2]; h1l[k] = s[ 3]; \
+		h2h[k] = s[ 4]; h2l[k] = s[ 5]; h3h[k] = s[ 6]; h3l[k] = s[ 7]; \
+		h4h[k] = s[ 8]; h4l[k] = s[ 9]; h5h[k] = s[10]; h5l[k] = s[11]; \
+		h6h[k] = s[12]; h6l[k] = s[13]; h7h[k] = s[14]; h7l[k] = s[15]; \
+		m0h[k] = dec64e(b +  0); m0l[k] = dec64e(b +  8); \
+		m1h[k] = dec64e(b + 16); m1l[k] = dec64e(b + 24); \
+		m2h[k] = dec64e(b + 32); m2l[k] = dec64e(b + 40); \
+		m3h[k] = dec64e(b + 48); m3l[k] = dec64e(b + 56); \
+	} while (0)
+
+#define LANE_WRITE(k)   do { \
+		sph_u64 *s = H[k]; \
+		s[ 0] = h0h[k]; s[ 1] = h0l[k]; s[ 2] = h1h[k]; s[ 3] = h1l[k]; \
+		s[ 4] = h2h[k]; s[ 5] = h2l[k]; s[ 6] = h3h[k]; s[ 7] = h3l[k]; \
+		s[ 8] = h4h[k]; s[ 9] = h4l[k]; s[10] = h5h[k]; s[11] = h5l[k]; \
+		s[12] = h6h[k]; s[13] = h6l[k]; s[14] = h7h[k]; s[15] = h7l[k]; \
+	} while (0)
+
+/*
+ * Compress one 64-byte block into each of n chaining values. H[k]
+ * points to the 16 state words of lane k, blk[k] to its (possibly
+ * unaligned) message block.
+ */
+#define JH_LANES_FN(name, vt, n) \
+static void \
+name(sph_u64 *const *H, const unsigned char *const *blk) \
+{ \
+	vt h0h, h1h, h2h, h3h, h4h, h5h, h6h, h7h; \
+	vt h0l, h1l, h2l, h3l, h4l, h5l, h6l, h7l; \
+	vt m0h, m0l, m1h, m1l, m2h, m2l, m3h, m3l; \
+	vt tmp; \
+	unsigned k; \
+ \
+	for (k = 0; k < (n); k ++) \
+		LANE_READ(k); \
+	h0h ^= m0h; h0l ^= m0l; h1h ^= m1h; h1l ^= m1l; \
+	h2h ^= m2h; h2l ^= m2l; h3h ^= m3h; h3l ^= m3l; \
+	E8; \
+	h4h ^= m0h; h4l ^= m0l; h5h ^= m1h; h5l ^= m1l; \
+	h6h ^= m2h; h6l ^= m2l; h7h ^= m3h; h7l ^= m3l; \
+	for (k = 0; k < (n); k ++) \
+		LANE_WRITE(k); \
+}
+
+typedef sph_u64 jh_v2 __attribute__((vector_size(16)));
+
+JH_LANES_FN(jh_lanes2, jh_v2, 2)
+
+#if JH_X86_DISPATCH
+
+typedef sph_u64 jh_v4 __attribute__((vector_size(32)));
+
+JH_TARGET("avx2") JH_LANES_FN(jh_lanes4, jh_v4, 4)
+
+#endif
+
+#endif
+
+#if SPH_JH_64
+
+/*
+ * A message in flight: its blocks are an optional head block (bytes
+ * buffered in the start context completed from the data), the whole
+ * blocks read directly from the data, and one or two tail blocks
+ * holding the last bytes and the padding.
+ */
+typedef struct {
+	sph_jh_context sc;
+	const unsigned char *data;
+	size_t full;
+	unsigned nhead, ntail, tail_off;
+	unsigned char head[64];
+	unsigned char tail[128];
+	unsigned char *dst;
+} jh_lane;
+
+static void
+jh_lane_start(jh_lane *ln, const sph_jh_context *sc,
+	const unsigned char *data, size_t len, unsigned char *dst)
+{
+	size_t ptr, total, r;
+	sph_u64 bc, l0, l1;
+
+	JH_STAT_ADD(JH_STAT_BYTES, len);
+	ptr = sc->ptr;
+	total = ptr + len;
+	memcpy(ln->sc.H.wide, sc->H.wide, sizeof sc->H.wide);
+	ln->sc.ptr = 0;
+	ln->sc.block_count = 0;
+	ln->dst = dst;
+	ln->nhead = 0;
+	r = 0;
+	if (ptr > 0 && total < 64) {
+		memcpy(ln->tail, sc->buf, ptr);
+		memcpy(ln->tail + ptr, data, len);
+		r = total;
+		len = 0;
+	} else if (ptr > 0) {
+		memcpy(ln->head, sc->buf, ptr);
+		memcpy(ln->head + ptr, data, 64 - ptr);
+		ln->nhead = 1;
+		data += 64 - ptr;
+		len -= 64 - ptr;
+	}
+	ln->data = data;
+	ln->full = len >> 6;
+	if (len & 63) {
+		r = len & 63;
+		memcpy(ln->tail, data + (len & ~(size_t)63), r);
+	}
+
+	/* same padding as jh_close() with n = 0 */
+	bc = sc->block_count + (total >> 6);
+	l0 = SPH_T64(bc << 9) + (r << 3);
+	l1 = SPH_T64(bc >> 55);
+	ln->tail[r] = 0x80;
+	if (r == 0) {
+		memset(ln->tail + 1, 0, 47);
+		sph_enc64be(ln->tail + 48, l1);
+		sph_enc64be(ln->tail + 56, l0);
+		ln->ntail = 1;
+	} else {
+		memset(ln->tail + r + 1, 0, 111 - r);
+		sph_enc64be(ln->tail + 112, l1);
+		sph_enc64be(ln->tail + 120, l0);
+		ln->ntail = 2;
+	}
+	ln->tail_off = 0;
+}
+
+static const unsigned char *
+jh_lane_next(jh_lane *ln)
+{
+	const unsigned char *b;
+
+	if (ln->nhead) {
+		ln->nhead = 0;
+		return ln->head;
+	}
+	if (ln->full) {
+		b = ln->data;
+		ln->data += 64;
+		ln->full --;
+		return b;
+	}
+	b = ln->tail + ln->tail_off;
+	ln->tail_off += 64;
+	ln->ntail --;
+	return b;
+}
+
+static void
+jh_lane_output(jh_lane *ln, size_t out_size_w32)
+{
+	unsigned char buf[64];
+	size_t u;
+
+	for (u = 0; u < 8; u ++)
+		enc64e(buf + (u << 3), ln->sc.H.wide[u + 8]);
+	memcpy(ln->dst, buf + ((16 - out_size_w32) << 2), out_size_w32 << 2);
+	JH_STAT_ADD(JH_STAT_FINALS, 1);
+	JH_PROBE2(final, &ln->sc, out_size_w32 << 5);
+}
+
+#endif
+
+/* see sph_jh.h */
+int
+sph_jh_multi_lanes(void)
+{
+#if SPH_JH_LANES
+#if JH_X86_DISPATCH
+	if (jh_cpu_features() & JH_CPU_AVX2)
+		return 4;
+#endif
+	return 2;
+#else
+	return 1;
+#endif
+}
+
+/* see sph_jh.h */
+void
+sph_jh_multi_close(const sph_jh_context *const *sc,
+	const void *const *data, const size_t *len, size_t n,
+	void *dst, unsigned out_size)
+{
+	size_t out_len, next;
+	unsigned char *out;
+
+	out = dst;
+	out_len = out_size >> 3;
+	if (out_size != 224 && out_size != 256
+		&& out_size != 384 && out_size != 512)
+		return;
+	JH_PROBE3(batch, "multi", n, out_size);
+
+#if SPH_JH_64
+	{
+		jh_lane lanes[4];
+		int busy[4] = { 0, 0, 0, 0 };
+		int width, s;
+		sph_u64 dummy_h[16];
+		unsigned char dummy_blk[64];
+
+		width = sph_jh_multi_lanes();
+		memset(dummy_h, 0, sizeof dummy_h);
+		memset(dummy_blk, 0, sizeof dummy_blk);
+		next = 0;
+		for (;;) {
+#if SPH_JH_LANES
+			sph_u64 *H[4];
+#endif
+			const unsigned char *blk[4];
+			int idx[4];
+			int active;
+
+			active = 0;
+			for (s = 0; s < width; s ++) {
+				if (!busy[s] && next < n) {
+					jh_lane_start(&lanes[s], sc[next],
+						data[next], len[next],
+						out + next * out_len);
+					busy[s] = 1;
+					next ++;
+				}
+				if (busy[s]) {
+#if SPH_JH_LANES
+					H[active] = lanes[s].sc.H.wide;
+#endif
+					blk[active] = jh_lane_next(&lanes[s]);
+					idx[active ++] = s;
+				}
+			}
+			if (active == 0)
+				break;
+#if SPH_JH_LANES
+#if JH_X86_DISPATCH
+			if (active > 2) {
+				for (s = active; s < 4; s ++) {
+					H[s] = dummy_h;
+					blk[s] = dummy_blk;
+				}
+				jh_lanes4(H, blk);
+				JH_STAT_ADD(JH_STAT_KERNEL_LANES4, 1);
+				JH_STAT_ADD(JH_STAT_BLOCKS, active);
+			} else
+#endif
+			if (active == 2) {
+				jh_lanes2(H, blk);
+				JH_STAT_ADD(JH_STAT_KERNEL_LANES2, 1);
+				JH_STAT_ADD(JH_STAT_BLOCKS, 2);
+			} else
+#endif
+			{
+				for (s = 0; s < active; s ++)
+					jh_core(&lanes[idx[s]].sc, blk[s], 64);
+			}
+			for (s = 0; s < active; s ++) {
+				jh_lane *ln = &lanes[idx[s]];
+				if (!ln->nhead && !ln->full && !ln->ntail) {
+					jh_lane_output(ln, out_len >> 2);
+					busy[idx[s]] = 0;
+				}
+			}
+		}
+	}
+#else
+	for (next = 0; next < n; next ++) {
+		sph_jh_context tmp;
+
+		tmp = *sc[next];
+		JH_STAT_ADD(JH_STAT_BYTES, len[next]);
+		jh_core(&tmp, data[next], len[next]);
+		sph_jh_close_size(&tmp, out + next * out_len, out_size);
+	}
+#endif
+}
+
+/*
+ * Hash chains: every step hashes one digest, so the two blocks of a step
+ * are fixed except for the digest words, and those are taken straight
+ * from the state left by the previous step. Between steps, nothing is
+ * buffered or encoded.
+ */
+
+#if SPH_JH_64
+
+/* the 64-bit word made of bytes 4..11 of two encoded state words */
+#if SPH_LITTLE_ENDIAN
+#define CAT32(a, b)   (((a) >> 32) | ((b) << 32))
+#else
+#define CAT32(a, b)   (((a) << 32) | ((b) >> 32))
+#endif
+
+#define LANE1(x, k)   (x)
+#define LANEV(x, k)   ((x)[k])
+
+/*
+ * Apply count steps to n chains. W[k] holds the words of the first
+ * block of chain k, that is its digest followed by the padding; pad
+ * holds the padding words of the first block (with a zero digest) and
+ * of the second block.
+ */
+#define JH_CHAIN_FN(name, vt, n, L) \
+static void \
+name(sph_u64 (*W)[8], unsigned long count, unsigned out_size, \
+	const sph_u64 *iv, const sph_u64 *pad) \
+{ \
+	vt h0h, h1h, h2h, h3h, h4h, h5h, h6h, h7h; \
+	vt h0l, h1l, h2l, h3l, h4l, h5l, h6l, h7l; \
+	vt m0h, m0l, m1h, m1l, m2h, m2l, m3h, m3l; \
+	vt tmp, z = { 0 }; \
+	unsigned k, b; \
+ \
+	for (k = 0; k < (n); k ++) { \
+		L(m0h, k) = W[k][0]; L(m0l, k) = W[k][1]; \
+		L(m1h, k) = W[k][2]; L(m1l, k) = W[k][3]; \
+		L(m2h, k) = W[k][4]; L(m2l, k) = W[k][5]; \
+		L(m3h, k) = W[k][6]; L(m3l, k) = W[k][7]; \
+	} \
+	while (count -- > 0) { \
+		h0h = z + iv[ 0]; h0l = z + iv[ 1]; \
+		h1h = z + iv[ 2]; h1l = z + iv[ 3]; \
+		h2h = z + iv[ 4]; h2l = z + iv[ 5]; \
+		h3h = z + iv[ 6]; h3l = z + iv[ 7]; \
+		h4h = z + iv[ 8]; h4l = z + iv[ 9]; \
+		h5h = z + iv[10]; h5l = z + iv[11]; \
+		h6h = z + iv[12]; h6l = z + iv[13]; \
+		h7h = z + iv[14]; h7l = z + iv[15]; \
+		for (b = 0; b < 2; b ++) { \
+			h0h ^= m0h; h0l ^= m0l; h1h ^= m1h; h1l ^= m1l; \
+			h2h ^= m2h; h2l ^= m2l; h3h ^= m3h; h3l ^= m3l; \
+			E8; \
+			h4h ^= m0h; h4l ^= m0l; h5h ^= m1h; h5l ^= m1l; \
+			h6h ^= m2h; h6l ^= m2l; h7h ^= m3h; h7l ^= m3l; \
+			m0h = z + pad[ 8]; m0l = z + pad[ 9]; \
+			m1h = z + pad[10]; m1l = z + pad[11]; \
+			m2h = z + pad[12]; m2l = z + pad[13]; \
+			m3h = z + pad[14]; m3l = z + pad[15]; \
+		} \
+		m0h = m0l = m1h = m1l = m2h = m2l = m3h = m3l = z; \
+		switch (out_size) { \
+		case 224: \
+			m0h = CAT32(h6h, h6l); m0l = CAT32(h6l, h7h); \
+			m1h = CAT32(h7h, h7l); m1l = CAT32(h7l, z); \
+			break; \
+		case 256: \
+			m0h = h6h; m0l = h6l; m1h = h7h; m1l = h7l; \
+			break; \
+		case 384: \
+			m0h = h5h; m0l = h5l; m1h = h6h; m1l = h6l; \
+			m2h = h7h; m2l = h7l; \
+			break; \
+		default: \
+			m0h = h4h; m0l = h4l; m1h = h5h; m1l = h5l; \
+			m2h = h6h; m2l = h6l; m3h = h7h; m3l = h7l; \
+			break; \
+		} \
+		m0h |= pad[0]; m0l |= pad[1]; m1h |= pad[2]; m1l |= pad[3]; \
+		m2h |= pad[4]; m2l |= pad[5]; m3h |= pad[6]; m3l |= pad[7]; \
+	} \
+	for (k = 0; k < (n); k ++) { \
+		W[k][0] = L(m0h, k); W[k][1] = L(m0l, k); \
+		W[k][2] = L(m1h, k); W[k][3] = L(m1l, k); \
+		W[k][4] = L(m2h, k); W[k][5] = L(m2l, k); \
+		W[k][6] = L(m3h, k); W[k][7] = L(m3l, k); \
+	} \
+}
+
+JH_CHAIN_FN(jh_chain1, sph_u64, 1, LANE1)
+
+#if SPH_JH_LANES
+
+JH_CHAIN_FN(jh_chain2, jh_v2, 2, LANEV)
+
+#if JH_X86_DISPATCH
+
+JH_TARGET("avx2") JH_CHAIN_FN(jh_chain4, jh_v4, 4, LANEV)
+
+#endif
+
+#endif
+
+#endif
+
+/* see sph_jh.h */
+void
+sph_jh_chain(void *buf, size_t n, unsigned long count, unsigned out_size)
+{
+	unsigned char *p;
+	size_t out_len;
+	const void *iv;
+
+	p = buf;
+	out_len = out_size >> 3;
+	switch (out_size) {
+	case 224:
+		iv = IV224;
+		break;
+	case 256:
+		iv = IV256;
+		break;
+	case 384:
+		iv = IV384;
+		break;
+	case 512:
+		iv = IV512;
+		break;
+	default:
+		return;
+	}
+	if (count == 0)
+		return;
+	JH_PROBE3(batch, "chain", n * count, out_size);
+
+#if SPH_JH_64
+	{
+		unsigned char blk[128];
+		sph_u64 pad[16], W[4][8];
+		size_t i, k, u, width, group;
+
+		/* the padding of a message of out_len bytes */
+		memset(blk, 0, sizeof blk);
+		blk[out_len] = 0x80;
+		sph_enc64be(blk + 120, (sph_u64)out_len << 3);
+		for (u = 0; u < 16; u ++)
+			pad[u] = dec64e(blk + (u << 3));
+
+		memset(W, 0, sizeof W);
+		width = sph_jh_multi_lanes();
+		for (i = 0; i < n; i += group) {
+			group = n - i < width ? n - i : width;
+			for (k = 0; k < group; k ++) {
+				memcpy(blk, p + (i + k) * out_len, out_len);
+				for (u = 0; u < 8; u ++)
+					W[k][u] = dec64e(blk + (u << 3));
+			}
+#if SPH_JH_LANES
+#if JH_X86_DISPATCH
+			if (group > 2) {
+				jh_chain4(W, count, out_size, iv, pad);
+				JH_STAT_ADD(JH_STAT_KERNEL_CHAIN4, 1);
+			} else
+#endif
+			if (group == 2) {
+				jh_chain2(W, count, out_size, iv, pad);
+				JH_STAT_ADD(JH_STAT_KERNEL_CHAIN2, 1);
+			} else
+#endif
+			{
+				jh_chain1(W, count, out_size, iv, pad);
+				JH_STAT_ADD(JH_STAT_KERNEL_CHAIN1, 1);
+			}
+			/* each link is one message of two blocks */
+			JH_STAT_ADD(JH_STAT_BYTES, group * count * out_len);
+			JH_STAT_ADD(JH_STAT_BLOCKS, group * count * 2);
+			JH_STAT_ADD(JH_STAT_FINALS, group * count);
+			for (k = 0; k < group; k ++) {
+				for (u = 0; u < 8; u ++)
+					enc64e(blk + (u << 3), W[k][u]);
+				memcpy(p + (i + k) * out_len, blk, out_len);
+			}
+		}
+	}
+#else
+	{
+		sph_jh_context sc;
+		size_t i;
+		unsigned long c;
+
+		for (i = 0; i < n; i ++, p += out_len) {
+			for (c = 0; c < count; c ++) {
+				jh_init(&sc, iv);
+				JH_STAT_ADD(JH_STAT_BYTES, out_len);
+				jh_core(&sc, p, out_len);
+				sph_jh_close_size(&sc, p, out_size);
+			}
+		}
+	}
+#endif
+}
+
+/*
+ * Fixed-length messages: the padding blocks depend only on the length,
+ * so they are built once, and the blocks are loaded word by word from
+ * the message or the padding, without going through a context buffer.
+ */
+
+/* see sph_jh.h */
+int
+sph_jh_fixed_init(sph_jh_fixed *fx, size_t len, unsigned out_size)
+{
+	size_t tail;
+
+	switch (out_size) {
+	case 224:
+		fx->iv = IV224;
+		break;
+	case 256:
+		fx->iv = IV256;
+		break;
+	case 384:
+		fx->iv = IV384;
+		break;
+	case 512:
+		fx->iv = IV512;
+		break;
+	default:
+		return -1;
+	}
+	fx->len = len;
+	fx->out_size = out_size;
+
+	/* same padding as jh_close() with n = 0 */
+	tail = (len & 63) ? 128 : 64;
+	fx->blocks = (len >> 6) + (tail >> 6);
+	memset(fx->pad, 0, sizeof fx->pad);
+	fx->pad[len & 63] = 0x80;
+#if SPH_64
+	sph_enc64be(fx->pad + tail - 16, SPH_T64((sph_u64)len >> 61));
+	sph_enc64be(fx->pad + tail - 8, SPH_T64((sph_u64)len << 3));
+#else
+	sph_enc32be(fx->pad + tail - 12, (sph_u32)(len >> 29));
+	sph_enc32be(fx->pad + tail - 4, SPH_T32((sph_u32)len << 3));
+#endif
+#if SPH_JH_64
+	{
+		unsigned u;
+
+		for (u = 0; u < 16; u ++)
+			fx->padw[u] = dec64e(fx->pad + (u << 3));
+	}
+#endif
+	return 0;
+}
+
+#if SPH_JH_64
+
+/* the message word at byte offset off, with the padding after the data */
+static sph_u64
+jh_fixed_word(const sph_jh_fixed *fx, const unsigned char *data, size_t off)
+{
+	unsigned char t[8];
+	size_t tail;
+
+	if (off + 8 <= fx->len)
+		return dec64e(data + off);
+	tail = fx->len & ~(size_t)63;
+	if (off >= fx->len)
+		return fx->padw[(off - tail) >> 3];
+	memcpy(t, fx->pad + (off - tail), 8);
+	memcpy(t, data + off, fx->len - off);
+	return dec64e(t);
+}
+
+#define JH_FIXED_FN(name, vt, n, L) \
+static void \
+name(const sph_jh_fixed *fx, const unsigned char *const *data, \
+	unsigned char *const *dst) \
+{ \
+	vt h0h, h1h, h2h, h3h, h4h, h5h, h6h, h7h; \
+	vt h0l, h1l, h2l, h3l, h4l, h5l, h6l, h7l; \
+	vt m0h, m0l, m1h, m1l, m2h, m2l, m3h, m3l; \
+	vt tmp, z = { 0 }; \
+	const sph_u64 *iv = fx->iv; \
+	unsigned char buf[64]; \
+	size_t off, end, out_len; \
+	unsigned k; \
+ \
+	h0h = z + iv[ 0]; h0l = z + iv[ 1]; h1h = z + iv[ 2]; h1l = z + iv[ 3]; \
+	h2h = z + iv[ 4]; h2l = z + iv[ 5]; h3h = z + iv[ 6]; h3l = z + iv[ 7]; \
+	h4h = z + iv[ 8]; h4l = z + iv[ 9]; h5h = z + iv[10]; h5l = z + iv[11]; \
+	h6h = z + iv[12]; h6l = z + iv[13]; h7h = z + iv[14]; h7l = z + iv[15]; \
+	end = fx->blocks << 6; \
+	for (off = 0; off < end; off += 64) { \
+		for (k = 0; k < (n); k ++) { \
+			const unsigned char *d = data[k]; \
+			L(m0h, k) = jh_fixed_word(fx, d, off +  0); \
+			L(m0l, k) = jh_fixed_word(fx, d, off +  8); \
+			L(m1h, k) = jh_fixed_word(fx, d, off + 16); \
+			L(m1l, k) = jh_fixed_word(fx, d, off + 24); \
+			L(m2h, k) = jh_fixed_word(fx, d, off + 32); \
+			L(m2l, k) = jh_fixed_word(fx, d, off + 40); \
+			L(m3h, k) = jh_fixed_word(fx, d, off + 48); \
+			L(m3l, k) = jh_fixed_word(fx, d, off + 56); \
+		} \
+		h0h ^= m0h; h0l ^= m0l; h1h ^= m1h; h1l ^= m1l; \
+		h2h ^= m2h; h2l ^= m2l; h3h ^= m3h; h3l ^= m3l; \
+		E8; \
+		h4h ^= m0h; h4l ^= m0l; h5h ^= m1h; h5l ^= m1l; \
+		h6h ^= m2h; h6l ^= m2l; h7h ^= m3h; h7l ^= m3l; \
+	} \
+	out_len = fx->out_size >> 3; \
+	for (k = 0; k < (n); k ++) { \
+		enc64e(buf +  0, L(h4h, k)); enc64e(buf +  8, L(h4l, k)); \
+		enc64e(buf + 16, L(h5h, k)); enc64e(buf + 24, L(h5l, k)); \
+		enc64e(buf + 32, L(h6h, k)); enc64e(buf + 40, L(h6l, k)); \
+		enc64e(buf + 48, L(h7h, k)); enc64e(buf + 56, L(h7l, k)); \
+		memcpy(dst[k], buf + 64 - out_len, out_len); \
+	} \
+}
+
+JH_FIXED_FN(jh_fixed1, sph_u64, 1, LANE1)
+
+#if SPH_JH_LANES
+
+JH_FIXED_FN(jh_fixed2, jh_v2, 2, LANEV)
+
+#if JH_X86_DISPATCH
+
+JH_TARGET("avx2") JH_FIXED_FN(jh_fixed4, jh_v4, 4, LANEV)
+
+#endif
+
+#endif
+
+#define JH_FIXED_STATS(fx, n, kernel)   do { \
+		JH_STAT_ADD(kernel, 1); \
+		JH_STAT_ADD(JH_STAT_BYTES, (n) * (fx)->len); \
+		JH_STAT_ADD(JH_STAT_BLOCKS, (n) * (fx)->blocks); \
+		JH_STAT_ADD(JH_STAT_FINALS, (n)); \
+	} while (0)
+
+#endif
+
+/* see sph_jh.h */
+void
+sph_jh_fixed_hash(const sph_jh_fixed *fx, const void *data, void *dst)
+{
+#if SPH_JH_64
+	const unsigned char *d = data;
+	unsigned char *o = dst;
+
+	jh_fixed1(fx, &d, &o);
+	JH_FIXED_STATS(fx, 1, JH_STAT_KERNEL_FIXED1);
+#else
+	sph_jh_context sc;
+
+	jh_init(&sc, fx->iv);
+	JH_STAT_ADD(JH_STAT_BYTES, fx->len);
+	jh_core(&sc, data, fx->len);
+	sph_jh_close_size(&sc, dst, fx->out_size);
+#endif
+}
+
+/* see sph_jh.h */
+void
+sph_jh_fixed_many(const sph_jh_fixed *fx, const void *const *data,
+	size_t n, void *dst)
+{
+	unsigned char *out;
+	size_t i, out_len;
+
+	out = dst;
+	out_len = fx->out_size >> 3;
+	JH_PROBE3(batch, "fixed", n, fx->out_size);
+#if SPH_JH_LANES
+	{
+		const unsigned char *d[4];
+		unsigned char *o[4], spare[64];
+		size_t k, width, group;
+
+		width = sph_jh_multi_lanes();
+		for (i = 0; i < n; i += group) {
+			group = n - i < width ? n - i : width;
+			for (k = 0; k < 4; k ++) {
+				if (k < group) {
+					d[k] = data[i + k];
+					o[k] = out + (i + k) * out_len;
+				} else {
+					d[k] = data[i];
+					o[k] = spare;
+				}
+			}
+#if JH_X86_DISPATCH
+			if (group > 2) {
+				jh_fixed4(fx, d, o);
+				JH_FIXED_STATS(fx, group, JH_STAT_KERNEL_FIXED4);
+			} else
+#endif
+			if (group == 2) {
+				jh_fixed2(fx, d, o);
+				JH_FIXED_STATS(fx, 2, JH_STAT_KERNEL_FIXED2);
+			} else {
+				jh_fixed1(fx, d, o);
+				JH_FIXED_STATS(fx, 1, JH_STAT_KERNEL_FIXED1);
+			}
+		}
+	}
+#else
+	for (i = 0; i < n; i ++)
+		sph_jh_fixed_hash(fx, data[i], out + i * out_len);
+#endif
+}
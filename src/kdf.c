@@ -0,0 +1,131 @@
+/*
+ * Key derivation over HMAC-JH; see kdf.h.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "kdf.h"
+
+int
+jh_pbkdf2 (unsigned out_size, const void *const *pw, const size_t *pw_len,
+           size_t npw, const void *salt, size_t salt_len,
+           unsigned long iterations, void *dk, size_t dklen) {
+    size_t hlen = out_size >> 3;
+    size_t nblocks, njobs, i, j, b;
+    unsigned long iter;
+    jh_hmac_context *keys = NULL;
+    const jh_hmac_context **hc = NULL;
+    const void **u_ptrs = NULL;
+    size_t *u_lens = NULL;
+    unsigned char *u = NULL, *t = NULL;
+    jh_hmac_batch batch = { 0, NULL, NULL, NULL, NULL };
+    int ret = -1;
+
+    if (! iterations || (out_size != 224 && out_size != 256
+        && out_size != 384 && out_size != 512)
+        || JH_PBKDF2_TOO_LONG(dklen, hlen))
+        return -1;
+    nblocks = dklen / hlen + (dklen % hlen != 0);
+    if (npw && nblocks > (size_t)-1 / hlen / npw)
+        return -1;
+    njobs = nblocks * npw;
+    if (! njobs)
+        return 0;
+
+    keys = malloc(npw * sizeof *keys);
+    hc = malloc(njobs * sizeof *hc);
+    u_ptrs = malloc(njobs * sizeof *u_ptrs);
+    u_lens = malloc(njobs * sizeof *u_lens);
+    u = malloc(njobs * hlen);
+    t = malloc(njobs * hlen);
+    if (! keys || ! hc || ! u_ptrs || ! u_lens || ! u || ! t
+        || jh_hmac_batch_init(&batch, njobs) < 0)
+        goto done;
+
+    /* U_1 = PRF(P, S || INT(b)) */
+    for (i = 0; i < npw; i++) {
+        jh_hmac_init(&keys[i], out_size, pw[i], pw_len[i]);
+        for (b = 0; b < nblocks; b++) {
+            unsigned char be[4];
+            jh_hmac_context *k = &keys[i];
+            j = i * nblocks + b;
+            be[0] = (unsigned char)((b + 1) >> 24);
+            be[1] = (unsigned char)((b + 1) >> 16);
+            be[2] = (unsigned char)((b + 1) >> 8);
+            be[3] = (unsigned char)(b + 1);
+            jh_hmac_update(k, salt, salt_len);
+            jh_hmac_update(k, be, 4);
+            jh_hmac_close(k, u + j * hlen);
+            hc[j] = k;
+            u_ptrs[j] = u + j * hlen;
+            u_lens[j] = hlen;
+        }
+    }
+    memcpy(t, u, njobs * hlen);
+
+    /* U_c = PRF(P, U_{c-1}), T ^= U_c */
+    for (iter = 1; iter < iterations; iter++) {
+        jh_hmac_batch_mac(&batch, hc, u_ptrs, u_lens, njobs, u);
+        for (j = 0; j < njobs * hlen; j++)
+            t[j] ^= u[j];
+    }
+
+    for (i = 0; i < npw; i++)
+        memcpy((unsigned char *)dk + i * dklen, t + i * nblocks * hlen,
+            dklen);
+    ret = 0;
+
+done:
+    if (keys)
+        memset(keys, 0, npw * sizeof *keys);
+    free(keys);
+    free(hc);
+    free(u_ptrs);
+    free(u_lens);
+    free(u);
+    free(t);
+    jh_hmac_batch_free(&batch);
+    return ret;
+}
+
+int
+jh_hkdf_extract (unsigned out_size, const void *salt, size_t salt_len,
+                 const void *ikm, size_t ikm_len, void *prk) {
+    jh_hmac_context hc;
+
+    /* HMAC pads the key with zeros, so no salt and a zero salt agree. */
+    if (jh_hmac_init(&hc, out_size, salt, salt_len) < 0)
+        return -1;
+    jh_hmac_mac(&hc, ikm, ikm_len, prk);
+    memset(&hc, 0, sizeof hc);
+    return 0;
+}
+
+int
+jh_hkdf_expand (unsigned out_size, const void *prk, size_t prk_len,
+                const void *info, size_t info_len, void *okm, size_t len) {
+    jh_hmac_context hc;
+    unsigned char t[64];
+    unsigned char *out = okm;
+    size_t hlen = out_size >> 3, tlen = 0, n;
+    unsigned char i;
+
+    if (len > 255 * hlen || jh_hmac_init(&hc, out_size, prk, prk_len) < 0)
+        return -1;
+    /* T(i) = HMAC(PRK, T(i - 1) || info || i) */
+    for (i = 1; len; i++) {
+        jh_hmac_update(&hc, t, tlen);
+        jh_hmac_update(&hc, info, info_len);
+        jh_hmac_update(&hc, &i, 1);
+        jh_hmac_close(&hc, t);
+        tlen = hlen;
+        n = len < hlen ? len : hlen;
+        memcpy(out, t, n);
+        out += n;
+        len -= n;
+    }
+    memset(&hc, 0, sizeof hc);
+    memset(t, 0, sizeof t);
+    return 0;
+}
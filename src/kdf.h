@@ -0,0 +1,46 @@
+/*
+ * Key derivation over HMAC-JH.
+ */
+
+#ifndef JH_KDF_H__
+#define JH_KDF_H__
+
+#include <stddef.h>
+#include "hmac.h"
+
+/*
+ * PBKDF2 (RFC 8018) for npw passwords with the same salt, iteration
+ * count and key length. The dklen-byte keys are written consecutively
+ * to dk. All the output blocks of all the passwords are iterated
+ * together, so they share the vector lanes of the JH kernel. Returns -1
+ * on a bad output size, a zero iteration count, a key longer than
+ * JH_PBKDF2_MAX_BLOCKS blocks of out_size / 8 bytes (RFC 8018's
+ * "derived key too long"), or allocation failure.
+ */
+#define JH_PBKDF2_MAX_BLOCKS  0xffffffffUL
+
+/* Nonzero if a dklen-byte key needs more than JH_PBKDF2_MAX_BLOCKS blocks
+   of hlen bytes. */
+#define JH_PBKDF2_TOO_LONG(dklen, hlen) \
+    ((dklen) / (hlen) > JH_PBKDF2_MAX_BLOCKS - ((dklen) % (hlen) != 0))
+
+int jh_pbkdf2(unsigned out_size, const void *const *pw, const size_t *pw_len,
+    size_t npw, const void *salt, size_t salt_len, unsigned long iterations,
+    void *dk, size_t dklen);
+
+/*
+ * HKDF-Extract (RFC 5869): writes out_size / 8 bytes to prk. An empty
+ * salt stands for a string of zeros, as in the RFC. Returns -1 on a bad
+ * output size.
+ */
+int jh_hkdf_extract(unsigned out_size, const void *salt, size_t salt_len,
+    const void *ikm, size_t ikm_len, void *prk);
+
+/*
+ * HKDF-Expand (RFC 5869): writes len bytes to okm. Returns -1 on a bad
+ * output size or if len exceeds 255 digests.
+ */
+int jh_hkdf_expand(unsigned out_size, const void *prk, size_t prk_len,
+    const void *info, size_t info_len, void *okm, size_t len);
+
+#endif
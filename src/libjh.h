@@ -0,0 +1,48 @@
+/*
+ * libjh: the C library under Digest::JH, for programs that use the
+ * same kernels without Perl. "make libjh" builds src/libjh.a and a
+ * shared src/libjh.so; link with -ljh, and -lpthread where POSIX
+ * threads are available. Everything is declared by the headers below:
+ *
+ *   sph_jh.h   contexts (sph_jh_init_size, sph_jh, sph_jh_close_size,
+ *              export and import), one-shot sph_jh_hash, multi-buffer
+ *              sph_jh_multi_close, which hashes messages continuing
+ *              from contexts side by side in the vector lanes, and the
+ *              batches of hash chains and of fixed-length messages
+ *   hmac.h     HMAC, one message at a time or in batches
+ *   kdf.h      PBKDF2 and HKDF
+ *   drbg.h     Hash_DRBG
+ *   prefix.h   a cache of contexts keyed by common message prefixes
+ *   merkle.h   tree mode: an append-only Merkle log with proofs
+ *   pieces.h   digests of fixed-size pieces and content-defined chunks
+ *              of a stream, hashed by a thread pool
+ *   delta.h    rsync-style signatures and deltas
+ *
+ * Functions that can fail return a negative value or NULL. Apart from
+ * the CPU features detected on first use, there is no global state, so
+ * separate objects may be used from separate threads.
+ */
+
+#ifndef JH_LIBJH_H__
+#define JH_LIBJH_H__
+
+#define LIBJH_VERSION  "0.05"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "sph_jh.h"
+#include "hmac.h"
+#include "kdf.h"
+#include "drbg.h"
+#include "prefix.h"
+#include "merkle.h"
+#include "pieces.h"
+#include "delta.h"
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
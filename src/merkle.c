@@ -0,0 +1,410 @@
+/*
+ * Append-only Merkle tree log; see merkle.h.
+ *
+ * A file-backed log starts with a 16-byte header: "JHML", a version
+ * byte, the hash length in bytes, two zero bytes, and the number of
+ * leaves as a 64-bit big-endian integer. The stored nodes follow.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "merkle.h"
+
+#define MERKLE_HEADER   16
+#define MERKLE_VERSION  1
+#define MERKLE_LEVELS   (sizeof(size_t) * 8)
+
+enum { STORE_NONE, STORE_MEMORY, STORE_FILE };
+
+struct jh_merkle {
+    unsigned out_size;
+    size_t hlen;
+    size_t size;
+    int store;
+    sph_jh_context leaf_start;     /* after the 0x00 prefix */
+    sph_jh_fixed node;             /* 0x01 || left || right */
+    unsigned char frontier[MERKLE_LEVELS][64];
+    unsigned char *nodes;          /* in-order layout */
+    size_t cap;                    /* capacity of nodes, in hashes */
+    int fd;
+    unsigned char *map;
+    size_t map_len;
+};
+
+/* Node i of level l, that is the root of leaves i << l to (i + 1) << l. */
+static unsigned char *
+node_at (const jh_merkle *m, unsigned l, size_t i) {
+    return m->nodes + ((i << (l + 1)) + ((size_t)1 << l) - 1) * m->hlen;
+}
+
+static void
+hash_node (const jh_merkle *m, const unsigned char *left,
+           const unsigned char *right, unsigned char *dst) {
+    unsigned char msg[1 + 2 * 64];
+    msg[0] = 1;
+    memcpy(msg + 1, left, m->hlen);
+    memcpy(msg + 1 + m->hlen, right, m->hlen);
+    sph_jh_fixed_hash(&m->node, msg, dst);
+}
+
+/* The largest power of two below n, for n >= 2. */
+static size_t
+split_point (size_t n) {
+    size_t k = 1;
+    while (k << 1 < n)
+        k <<= 1;
+    return k;
+}
+
+/*
+ * The hash of leaves lo to hi, where lo is a multiple of the largest
+ * power of two not above hi - lo: the complete subtrees that make up
+ * the range are folded from the right. Without stored nodes, this is
+ * only used for the whole tree, whose complete subtrees are the
+ * frontier.
+ */
+static void
+range_hash (const jh_merkle *m, size_t lo, size_t hi, unsigned char *dst) {
+    size_t len = hi - lo;
+    const unsigned char *piece;
+    unsigned l;
+    int first = 1;
+
+    for (l = 0; len; l++) {
+        if (! (len & ((size_t)1 << l)))
+            continue;
+        len &= ~((size_t)1 << l);
+        hi -= (size_t)1 << l;
+        piece = m->nodes ? node_at(m, l, hi >> l) : m->frontier[l];
+        if (first) {
+            memcpy(dst, piece, m->hlen);
+            first = 0;
+        }
+        else
+            hash_node(m, piece, dst, dst);
+    }
+}
+
+static jh_merkle *
+merkle_alloc (unsigned out_size) {
+    jh_merkle *m;
+    sph_jh_context sc;
+
+    if (sph_jh_init_size(&sc, out_size) < 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    m = calloc(1, sizeof *m);
+    if (! m)
+        return NULL;
+    m->out_size = out_size;
+    m->hlen = out_size >> 3;
+    m->leaf_start = sc;
+    sph_jh(&m->leaf_start, "", 1);
+    sph_jh_fixed_init(&m->node, 1 + 2 * m->hlen, out_size);
+    m->fd = -1;
+    return m;
+}
+
+jh_merkle *
+jh_merkle_new (unsigned out_size, int store_nodes) {
+    jh_merkle *m = merkle_alloc(out_size);
+    if (m)
+        m->store = store_nodes ? STORE_MEMORY : STORE_NONE;
+    return m;
+}
+
+#ifndef _WIN32
+
+static int
+map_file (jh_merkle *m, size_t len) {
+    void *p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, m->fd, 0);
+    if (p == MAP_FAILED)
+        return -1;
+    if (m->map)
+        munmap(m->map, m->map_len);
+    m->map = p;
+    m->map_len = len;
+    m->nodes = m->map + MERKLE_HEADER;
+    m->cap = (len - MERKLE_HEADER) / m->hlen;
+    return 0;
+}
+
+#endif
+
+/* Makes room for the nodes of a tree of the given size. */
+static int
+reserve (jh_merkle *m, size_t size) {
+    size_t need = 2 * size - 1, cap = m->cap ? m->cap : 64;
+    unsigned char *p;
+
+    if (m->store == STORE_NONE || need <= m->cap)
+        return 0;
+    while (cap < need)
+        cap *= 2;
+    if (m->store == STORE_MEMORY) {
+        p = realloc(m->nodes, cap * m->hlen);
+        if (! p)
+            return -1;
+        m->nodes = p;
+        m->cap = cap;
+        return 0;
+    }
+#ifndef _WIN32
+    if (ftruncate(m->fd, MERKLE_HEADER + cap * m->hlen) < 0)
+        return -1;
+    return map_file(m, MERKLE_HEADER + cap * m->hlen);
+#else
+    return -1;
+#endif
+}
+
+jh_merkle *
+jh_merkle_open (unsigned out_size, const char *path) {
+#ifndef _WIN32
+    jh_merkle *m;
+    struct stat st;
+    unsigned char *h;
+    size_t size;
+    unsigned l, i;
+    int err;
+
+    m = merkle_alloc(out_size);
+    if (! m)
+        return NULL;
+    m->store = STORE_FILE;
+    m->fd = open(path, O_RDWR | O_CREAT, 0666);
+    if (m->fd < 0 || fstat(m->fd, &st) < 0)
+        goto fail;
+
+    if (st.st_size == 0) {
+        if (reserve(m, 1) < 0)
+            goto fail;
+        memcpy(m->map, "JHML", 4);
+        m->map[4] = MERKLE_VERSION;
+        m->map[5] = (unsigned char)m->hlen;
+        return m;
+    }
+
+    errno = EINVAL;
+    if ((size_t)st.st_size < MERKLE_HEADER + m->hlen)
+        goto fail;
+    if (map_file(m, st.st_size) < 0)
+        goto fail;
+    h = m->map;
+    errno = EINVAL;
+    if (memcmp(h, "JHML", 4) || h[4] != MERKLE_VERSION || h[5] != m->hlen)
+        goto fail;
+    for (size = 0, i = 8; i < 16; i++)
+        size = (size << 8) | h[i];
+    if (size && 2 * size - 1 > m->cap)
+        goto fail;
+    m->size = size;
+    for (l = 0; l < MERKLE_LEVELS; l++)
+        if (size & ((size_t)1 << l))
+            memcpy(m->frontier[l], node_at(m, l, (size >> l) - 1), m->hlen);
+    return m;
+
+fail:
+    err = errno;
+    jh_merkle_free(m);
+    errno = err;
+    return NULL;
+#else
+    errno = ENOSYS;
+    return NULL;
+#endif
+}
+
+void
+jh_merkle_free (jh_merkle *m) {
+    if (! m)
+        return;
+#ifndef _WIN32
+    if (m->map)
+        munmap(m->map, m->map_len);
+    if (m->fd >= 0)
+        close(m->fd);
+#endif
+    if (m->store == STORE_MEMORY)
+        free(m->nodes);
+    free(m);
+}
+
+int
+jh_merkle_append (jh_merkle *m, const void *const *data,
+                  const size_t *len, size_t n) {
+    const sph_jh_context **starts = NULL;
+    const void **msgs = NULL;
+    unsigned char *cur = NULL, *buf = NULL, *p;
+    size_t hlen = m->hlen, mlen = 1 + 2 * m->hlen;
+    size_t s, e, i, j, k;
+    unsigned l;
+    int ret = -1;
+
+    if (! n)
+        return 0;
+    starts = malloc(n * sizeof *starts);
+    msgs = malloc((n / 2 + 1) * sizeof *msgs);
+    cur = malloc(n * hlen);
+    buf = malloc((n / 2 + 1) * mlen);
+    if (! starts || ! msgs || ! cur || ! buf
+        || reserve(m, m->size + n) < 0)
+        goto done;
+
+    for (i = 0; i < n; i++)
+        starts[i] = &m->leaf_start;
+    sph_jh_multi_close(starts, data, len, n, cur, m->out_size);
+
+    /* cur holds the new nodes s to e of level l */
+    s = m->size;
+    e = s + n;
+    for (l = 0; ; l++) {
+        if (m->store != STORE_NONE)
+            for (i = s; i < e; i++)
+                memcpy(node_at(m, l, i), cur + (i - s) * hlen, hlen);
+        for (j = s >> 1, k = 0; j < e >> 1; j++, k++) {
+            p = buf + k * mlen;
+            p[0] = 1;
+            memcpy(p + 1, 2 * j < s ? m->frontier[l]
+                : cur + (2 * j - s) * hlen, hlen);
+            memcpy(p + 1 + hlen, cur + (2 * j + 1 - s) * hlen, hlen);
+            msgs[k] = p;
+        }
+        if (e & 1)
+            memcpy(m->frontier[l], cur + (e - 1 - s) * hlen, hlen);
+        if (! k)
+            break;
+        sph_jh_fixed_many(&m->node, msgs, k, cur);
+        s >>= 1;
+        e >>= 1;
+    }
+
+    m->size += n;
+    if (m->store == STORE_FILE) {
+        size_t v = m->size;
+        for (i = 16; i-- > 8; v >>= 8)
+            m->map[i] = (unsigned char)v;
+    }
+    ret = 0;
+
+done:
+    free(starts);
+    free(msgs);
+    free(cur);
+    free(buf);
+    return ret;
+}
+
+unsigned
+jh_merkle_out_size (const jh_merkle *m) {
+    return m->out_size;
+}
+
+size_t
+jh_merkle_size (const jh_merkle *m) {
+    return m->size;
+}
+
+int
+jh_merkle_sync (jh_merkle *m) {
+#ifndef _WIN32
+    if (m->map)
+        return msync(m->map, m->map_len, MS_SYNC);
+#endif
+    return 0;
+}
+
+int
+jh_merkle_root (const jh_merkle *m, size_t size, void *dst) {
+    sph_jh_context sc;
+
+    if (size > m->size || (size != m->size && ! m->nodes))
+        return -1;
+    if (! size) {
+        sph_jh_init_size(&sc, m->out_size);
+        sph_jh_close_size(&sc, dst, m->out_size);
+    }
+    else
+        range_hash(m, 0, size, dst);
+    return 0;
+}
+
+int
+jh_merkle_leaf (const jh_merkle *m, size_t i, void *dst) {
+    if (i >= m->size || ! m->nodes)
+        return -1;
+    memcpy(dst, node_at(m, 0, i), m->hlen);
+    return 0;
+}
+
+int
+jh_merkle_inclusion (const jh_merkle *m, size_t i, size_t size,
+                     void *proof) {
+    size_t lo = 0, hi = size, k, r[JH_MERKLE_MAX_PROOF][2];
+    unsigned char *p = proof;
+    int n = 0, j;
+
+    if (i >= size || size > m->size || ! m->nodes)
+        return -1;
+    while (hi - lo > 1) {
+        k = split_point(hi - lo);
+        if (i < lo + k) {
+            r[n][0] = lo + k;
+            r[n][1] = hi;
+            hi = lo + k;
+        }
+        else {
+            r[n][0] = lo;
+            r[n][1] = lo + k;
+            lo += k;
+        }
+        n++;
+    }
+    for (j = n; j--; p += m->hlen)
+        range_hash(m, r[j][0], r[j][1], p);
+    return n;
+}
+
+int
+jh_merkle_consistency (const jh_merkle *m, size_t old_size, size_t size,
+                       void *proof) {
+    size_t lo = 0, hi = size, k, r[JH_MERKLE_MAX_PROOF][2];
+    unsigned char *p = proof;
+    int n = 0, whole = 1, j;
+
+    if (! old_size || old_size > size || size > m->size || ! m->nodes)
+        return -1;
+    while (old_size != hi) {
+        k = split_point(hi - lo);
+        if (old_size <= lo + k) {
+            r[n][0] = lo + k;
+            r[n][1] = hi;
+            hi = lo + k;
+        }
+        else {
+            r[n][0] = lo;
+            r[n][1] = lo + k;
+            lo += k;
+            whole = 0;
+        }
+        n++;
+    }
+    /* the old tree is a subtree of the new one, unless it is all of it */
+    if (! whole) {
+        r[n][0] = lo;
+        r[n][1] = hi;
+        n++;
+    }
+    for (j = n; j--; p += m->hlen)
+        range_hash(m, r[j][0], r[j][1], p);
+    return n;
+}
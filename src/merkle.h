@@ -0,0 +1,84 @@
+/*
+ * Append-only Merkle tree log, with the tree shape and hashing of
+ * RFC 6962 (Certificate Transparency): a leaf hash is JH(0x00 || data)
+ * and an interior node hash is JH(0x01 || left || right).
+ *
+ * The root of the current tree is computed from the right-edge
+ * frontier, one hash per level, which is all the log keeps in memory.
+ * Proofs need the hashes of complete subtrees, so the log can also
+ * store every such node, in memory or in a memory-mapped file, in the
+ * in-order ("flat tree") layout, which only grows at the end as leaves
+ * are appended.
+ */
+
+#ifndef JH_MERKLE_H__
+#define JH_MERKLE_H__
+
+#include <stddef.h>
+#include "sph_jh.h"
+
+/* The longest proof, in hashes. */
+#define JH_MERKLE_MAX_PROOF 64
+
+typedef struct jh_merkle jh_merkle;
+
+/*
+ * Returns a new empty log that keeps the complete-subtree nodes in
+ * memory when store_nodes is true, or the frontier only. Returns NULL
+ * on a bad output size or allocation failure.
+ */
+jh_merkle *jh_merkle_new(unsigned out_size, int store_nodes);
+
+/*
+ * Opens or creates a log whose nodes are stored in a memory-mapped
+ * file. Returns NULL, with errno set, if the file cannot be opened or
+ * mapped, or holds a log of another output size or a corrupt header.
+ */
+jh_merkle *jh_merkle_open(unsigned out_size, const char *path);
+
+void jh_merkle_free(jh_merkle *m);
+
+/*
+ * Appends n leaves. The leaf hashes are computed in the vector lanes,
+ * and the new interior nodes one level at a time, in batches of equal
+ * length messages. Returns -1 on allocation or mapping failure, in
+ * which case the log is unchanged.
+ */
+int jh_merkle_append(jh_merkle *m, const void *const *data,
+    const size_t *len, size_t n);
+
+unsigned jh_merkle_out_size(const jh_merkle *m);
+size_t jh_merkle_size(const jh_merkle *m);
+
+/* Flushes a file-backed log to disk; returns -1 on failure. */
+int jh_merkle_sync(jh_merkle *m);
+
+/*
+ * Writes the root of the tree of the first size leaves. Any size up to
+ * the current one works when the nodes are stored; otherwise only the
+ * current size does. Returns -1 if the root cannot be computed.
+ */
+int jh_merkle_root(const jh_merkle *m, size_t size, void *dst);
+
+/* Writes the hash of leaf i; returns -1 if it is not available. */
+int jh_merkle_leaf(const jh_merkle *m, size_t i, void *dst);
+
+/*
+ * Writes the audit path of leaf i in the tree of the first size leaves
+ * (RFC 6962, section 2.1.1), from the leaf up, and returns the number
+ * of hashes, or -1 if i >= size, size is larger than the log, or the
+ * nodes are not stored. proof must hold JH_MERKLE_MAX_PROOF hashes.
+ */
+int jh_merkle_inclusion(const jh_merkle *m, size_t i, size_t size,
+    void *proof);
+
+/*
+ * Writes the consistency proof between the trees of the first old_size
+ * and size leaves (RFC 6962, section 2.1.2), and returns the number of
+ * hashes, or -1 unless 0 < old_size <= size <= the log size and the
+ * nodes are stored.
+ */
+int jh_merkle_consistency(const jh_merkle *m, size_t old_size,
+    size_t size, void *proof);
+
+#endif
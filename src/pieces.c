@@ -0,0 +1,459 @@
+/*
+ * Piece hashing; see pieces.h.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#if !defined _WIN32 && !defined JH_NO_THREADS
+#define JH_THREADS 1
+#include <pthread.h>
+#include <unistd.h>
+#else
+#define JH_THREADS 0
+#endif
+
+#include "pieces.h"
+
+/* Bound on the memory of one batch, unless a single piece is larger. */
+#define BATCH_BYTES  ((size_t)32 << 20)
+#define MAX_THREADS  64
+
+typedef struct {
+    unsigned char *data;   /* count pieces, piece_size bytes apart */
+    size_t count, last;    /* number of pieces, length of the last one */
+    size_t *ends;          /* or, for chunks, the end of each one */
+    unsigned char *out;    /* their digests */
+} jh_piece_batch;
+
+typedef struct {
+    sph_jh_context start;
+    size_t piece_size, hlen, lanes;
+    unsigned out_size;
+#if JH_THREADS
+    pthread_mutex_t mu;
+    pthread_cond_t work, done;
+    jh_piece_batch *cur;   /* batch being hashed, if any */
+    size_t next, finished;
+    int quit;
+#endif
+} jh_piece_pool;
+
+/* Hashes pieces i to i + k of a batch, side by side. */
+static void
+hash_pieces (const jh_piece_pool *p, const jh_piece_batch *b, size_t i,
+             size_t k) {
+    const sph_jh_context *starts[4];
+    const void *data[4];
+    size_t len[4], j;
+
+    for (j = 0; j < k; j++) {
+        starts[j] = &p->start;
+        if (b->ends) {
+            size_t s = i + j ? b->ends[i + j - 1] : 0;
+            data[j] = b->data + s;
+            len[j] = b->ends[i + j] - s;
+            continue;
+        }
+        data[j] = b->data + (i + j) * p->piece_size;
+        len[j] = i + j == b->count - 1 ? b->last : p->piece_size;
+    }
+    sph_jh_multi_close(starts, data, len, k, b->out + i * p->hlen,
+        p->out_size);
+}
+
+/* Reads up to max pieces; returns -1 on a read error. */
+static int
+read_batch (jh_pieces_reader rd, void *ctx, const jh_piece_pool *p,
+            jh_piece_batch *b, size_t max, int *eof) {
+    unsigned char *dst;
+    size_t fill;
+    long r;
+
+    b->count = 0;
+    b->last = 0;
+    while (b->count < max && ! *eof) {
+        dst = b->data + b->count * p->piece_size;
+        for (fill = 0; fill < p->piece_size; fill += r) {
+            r = rd(ctx, dst + fill, p->piece_size - fill);
+            if (r < 0)
+                return -1;
+            if (r == 0) {
+                *eof = 1;
+                break;
+            }
+        }
+        if (fill) {
+            b->count++;
+            b->last = fill;
+        }
+    }
+    return 0;
+}
+
+#if JH_THREADS
+
+static void *
+worker (void *arg) {
+    jh_piece_pool *p = arg;
+    jh_piece_batch *b;
+    size_t i, k;
+
+    pthread_mutex_lock(&p->mu);
+    for (;;) {
+        while (! p->quit && (! p->cur || p->next >= p->cur->count))
+            pthread_cond_wait(&p->work, &p->mu);
+        if (p->quit)
+            break;
+        b = p->cur;
+        i = p->next;
+        k = b->count - i < p->lanes ? b->count - i : p->lanes;
+        p->next += k;
+        pthread_mutex_unlock(&p->mu);
+        hash_pieces(p, b, i, k);
+        pthread_mutex_lock(&p->mu);
+        p->finished += k;
+        if (p->finished == b->count)
+            pthread_cond_signal(&p->done);
+    }
+    pthread_mutex_unlock(&p->mu);
+    return NULL;
+}
+
+/* Sets up the pool; returns the number of threads started. */
+static unsigned
+pool_start (jh_piece_pool *p, unsigned threads, pthread_t *tid) {
+    unsigned n = 0;
+
+    pthread_mutex_init(&p->mu, NULL);
+    pthread_cond_init(&p->work, NULL);
+    pthread_cond_init(&p->done, NULL);
+    p->cur = NULL;
+    p->quit = 0;
+    while (n < threads && pthread_create(&tid[n], NULL, worker, p) == 0)
+        n++;
+    return n;
+}
+
+static void
+pool_stop (jh_piece_pool *p, pthread_t *tid, unsigned n) {
+    unsigned i;
+
+    pthread_mutex_lock(&p->mu);
+    p->quit = 1;
+    pthread_cond_broadcast(&p->work);
+    pthread_mutex_unlock(&p->mu);
+    for (i = 0; i < n; i++)
+        pthread_join(tid[i], NULL);
+    pthread_cond_destroy(&p->done);
+    pthread_cond_destroy(&p->work);
+    pthread_mutex_destroy(&p->mu);
+}
+
+#endif
+
+/*
+ * Starts hashing a batch, in the pool if there is one, or else hashes
+ * it right away.
+ */
+static void
+batch_start (jh_piece_pool *p, jh_piece_batch *b, unsigned nthreads) {
+    size_t i, k;
+
+#if JH_THREADS
+    if (nthreads) {
+        pthread_mutex_lock(&p->mu);
+        p->cur = b;
+        p->next = p->finished = 0;
+        pthread_cond_broadcast(&p->work);
+        pthread_mutex_unlock(&p->mu);
+        return;
+    }
+#endif
+    for (i = 0; i < b->count; i += k) {
+        k = b->count - i < p->lanes ? b->count - i : p->lanes;
+        hash_pieces(p, b, i, k);
+    }
+}
+
+static void
+batch_wait (jh_piece_pool *p, const jh_piece_batch *b, unsigned nthreads) {
+#if JH_THREADS
+    if (nthreads) {
+        pthread_mutex_lock(&p->mu);
+        while (p->finished < b->count)
+            pthread_cond_wait(&p->done, &p->mu);
+        p->cur = NULL;
+        pthread_mutex_unlock(&p->mu);
+    }
+#else
+    (void)p;
+    (void)b;
+    (void)nthreads;
+#endif
+}
+
+static int
+pool_init (jh_piece_pool *p, unsigned out_size, unsigned *threads) {
+    if (sph_jh_init_size(&p->start, out_size) < 0)
+        return -1;
+    p->hlen = out_size >> 3;
+    p->lanes = sph_jh_multi_lanes();
+    p->out_size = out_size;
+#if JH_THREADS
+    if (! *threads) {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        *threads = n > 0 ? (unsigned)n : 1;
+    }
+#endif
+    if (! *threads)
+        *threads = 1;
+    if (*threads > MAX_THREADS)
+        *threads = MAX_THREADS;
+    return 0;
+}
+
+long
+jh_pieces (jh_pieces_reader rd, void *ctx, size_t piece_size,
+           unsigned out_size, unsigned threads, unsigned char **digests) {
+    jh_piece_pool p;
+    jh_piece_batch bt[2];
+    unsigned char *out = NULL, *grown;
+    size_t per_batch, total = 0;
+    unsigned nthreads = 0;
+    int eof = 0, cur = 0, err;
+    long ret = -1;
+#if JH_THREADS
+    pthread_t tid[MAX_THREADS];
+#endif
+
+    *digests = NULL;
+    if (! piece_size || pool_init(&p, out_size, &threads) < 0)
+        return -1;
+    p.piece_size = piece_size;
+#if JH_THREADS
+    if (threads > 1)
+        nthreads = pool_start(&p, threads, tid);
+#endif
+
+    /* enough pieces to keep every lane of every thread busy */
+    per_batch = threads * p.lanes * 2;
+    if (per_batch > BATCH_BYTES / piece_size)
+        per_batch = BATCH_BYTES / piece_size;
+    if (! per_batch)
+        per_batch = 1;
+    bt[0].data = malloc(per_batch * piece_size);
+    bt[1].data = malloc(per_batch * piece_size);
+    bt[0].ends = bt[1].ends = NULL;
+    if (! bt[0].data || ! bt[1].data)
+        goto done;
+
+    if (read_batch(rd, ctx, &p, &bt[cur], per_batch, &eof) < 0)
+        goto done;
+    while (bt[cur].count) {
+        grown = realloc(out, (total + bt[cur].count) * p.hlen);
+        if (! grown)
+            goto done;
+        out = grown;
+        bt[cur].out = out + total * p.hlen;
+
+        /* hash this batch while the next one is read */
+        batch_start(&p, &bt[cur], nthreads);
+        err = read_batch(rd, ctx, &p, &bt[! cur], per_batch, &eof);
+        batch_wait(&p, &bt[cur], nthreads);
+        total += bt[cur].count;
+        if (err < 0)
+            goto done;
+        cur = ! cur;
+    }
+    *digests = out;
+    out = NULL;
+    ret = (long)total;
+
+done:
+#if JH_THREADS
+    if (threads > 1)
+        pool_stop(&p, tid, nthreads);
+#endif
+    free(bt[0].data);
+    free(bt[1].data);
+    free(out);
+    return ret;
+}
+
+/*
+ * The gear table of the chunker. Its entries are fixed, so that the
+ * same content is always cut in the same places: entry i is the
+ * MurmurHash3 finalizer of (i + 1) times the golden ratio.
+ */
+static void
+gear_table (sph_u32 *gear) {
+    sph_u32 h;
+    unsigned i;
+
+    for (i = 0; i < 256; i++) {
+        h = SPH_T32((sph_u32)(i + 1) * SPH_C32(0x9e3779b9));
+        h ^= h >> 16;
+        h = SPH_T32(h * SPH_C32(0x85ebca6b));
+        h ^= h >> 13;
+        h = SPH_T32(h * SPH_C32(0xc2b2ae35));
+        h ^= h >> 16;
+        gear[i] = h;
+    }
+}
+
+typedef struct {
+    sph_u32 gear[256];
+    sph_u32 mask_s, mask_l;   /* before and after the average size */
+    size_t min, avg, max;
+} jh_chunker;
+
+/* The n top bits, which depend on the last 32 bytes. */
+#define TOP_BITS(n)  SPH_T32(~(sph_u32)0 << (32 - (n)))
+
+/*
+ * FastCDC's cut point search, with normalization level 2: the boundary
+ * test uses two more bits than the average size calls for until the
+ * chunk reaches it, and two fewer after, which narrows the spread of
+ * chunk sizes. The first min bytes are skipped.
+ */
+static size_t
+cut_point (const jh_chunker *c, const unsigned char *p, size_t n) {
+    size_t i = c->min, end, normal;
+    sph_u32 h = 0;
+
+    if (n <= c->min)
+        return n;
+    end = n < c->max ? n : c->max;
+    normal = end < c->avg ? end : c->avg;
+    for (; i < normal; i++) {
+        h = SPH_T32((h << 1) + c->gear[p[i]]);
+        if (! (h & c->mask_s))
+            return i + 1;
+    }
+    for (; i < end; i++) {
+        h = SPH_T32((h << 1) + c->gear[p[i]]);
+        if (! (h & c->mask_l))
+            return i + 1;
+    }
+    return end;
+}
+
+/* Fills a buffer that already holds fill bytes; returns -1 on error. */
+static long
+read_fill (jh_pieces_reader rd, void *ctx, unsigned char *buf, size_t fill,
+           size_t cap, int *eof) {
+    long r;
+
+    while (fill < cap && ! *eof) {
+        r = rd(ctx, buf + fill, cap - fill);
+        if (r < 0)
+            return -1;
+        if (r == 0)
+            *eof = 1;
+        fill += r;
+    }
+    return (long)fill;
+}
+
+long
+jh_chunks (jh_pieces_reader rd, void *ctx, size_t min, size_t avg,
+           size_t max, unsigned out_size, unsigned threads,
+           size_t **lengths, unsigned char **digests) {
+    jh_piece_pool p;
+    jh_piece_batch bt[2];
+    jh_chunker c;
+    unsigned char *out = NULL, *grown;
+    size_t *lens = NULL, *glens, cap, per_batch, total = 0, pos, tail, i;
+    unsigned bits, nthreads = 0;
+    int eof = 0, cur = 0;
+    long fill, ret = -1;
+#if JH_THREADS
+    pthread_t tid[MAX_THREADS];
+#endif
+
+    *lengths = NULL;
+    *digests = NULL;
+    if (! min || min > avg || avg > max || avg < 64
+        || avg > ((size_t)1 << 28)
+        || pool_init(&p, out_size, &threads) < 0)
+        return -1;
+    p.piece_size = 0;
+    for (bits = 0; ((size_t)2 << bits) <= avg; bits++)
+        ;
+    gear_table(c.gear);
+    c.mask_s = TOP_BITS(bits + 2);
+    c.mask_l = TOP_BITS(bits - 2);
+    c.min = min;
+    c.avg = avg;
+    c.max = max;
+#if JH_THREADS
+    if (threads > 1)
+        nthreads = pool_start(&p, threads, tid);
+#endif
+
+    /* a batch always holds at least one chunk of the largest size */
+    cap = BATCH_BYTES > 2 * max ? BATCH_BYTES : 2 * max;
+    per_batch = cap / min + 1;
+    for (i = 0; i < 2; i++) {
+        bt[i].data = malloc(cap);
+        bt[i].ends = malloc(per_batch * sizeof *bt[i].ends);
+    }
+    if (! bt[0].data || ! bt[1].data || ! bt[0].ends || ! bt[1].ends)
+        goto done;
+
+    fill = read_fill(rd, ctx, bt[cur].data, 0, cap, &eof);
+    if (fill < 0)
+        goto done;
+    for (;;) {
+        /* a cut is final once max bytes are buffered, or at the end */
+        bt[cur].count = 0;
+        for (pos = 0; pos < (size_t)fill
+             && ((size_t)fill - pos >= max || eof); ) {
+            pos += cut_point(&c, bt[cur].data + pos, fill - pos);
+            bt[cur].ends[bt[cur].count++] = pos;
+        }
+        if (! bt[cur].count)
+            break;
+
+        grown = realloc(out, (total + bt[cur].count) * p.hlen);
+        if (! grown)
+            goto done;
+        out = grown;
+        glens = realloc(lens, (total + bt[cur].count) * sizeof *lens);
+        if (! glens)
+            goto done;
+        lens = glens;
+        for (i = 0; i < bt[cur].count; i++)
+            lens[total + i] = bt[cur].ends[i] - (i ? bt[cur].ends[i - 1] : 0);
+        bt[cur].out = out + total * p.hlen;
+
+        /* hash these chunks while the rest of the buffer is refilled */
+        batch_start(&p, &bt[cur], nthreads);
+        tail = fill - pos;
+        memcpy(bt[! cur].data, bt[cur].data + pos, tail);
+        fill = read_fill(rd, ctx, bt[! cur].data, tail, cap, &eof);
+        batch_wait(&p, &bt[cur], nthreads);
+        total += bt[cur].count;
+        if (fill < 0)
+            goto done;
+        cur = ! cur;
+    }
+    *lengths = lens;
+    *digests = out;
+    lens = NULL;
+    out = NULL;
+    ret = (long)total;
+
+done:
+#if JH_THREADS
+    if (threads > 1)
+        pool_stop(&p, tid, nthreads);
+#endif
+    for (i = 0; i < 2; i++) {
+        free(bt[i].data);
+        free(bt[i].ends);
+    }
+    free(lens);
+    free(out);
+    return ret;
+}
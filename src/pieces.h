@@ -0,0 +1,50 @@
+/*
+ * Piece hashing: a stream is cut into pieces, and each piece gets its
+ * own digest. The pieces have a fixed size (the last one may be
+ * shorter), as in BitTorrent-style distribution, or their boundaries
+ * depend on the content, as in deduplicating backups, so that an edit
+ * only changes the chunks around it.
+ *
+ * The stream is read once, sequentially, by the calling thread, in
+ * batches of pieces; while one batch is read, the previous one is
+ * hashed by a pool of threads, each taking as many pieces at a time as
+ * the vector lanes hold. Without thread support, the batches are hashed
+ * by the calling thread.
+ */
+
+#ifndef JH_PIECES_H__
+#define JH_PIECES_H__
+
+#include <stddef.h>
+#include "sph_jh.h"
+
+/*
+ * Reads up to len bytes; returns the number of bytes read, 0 at the end
+ * of the stream, or -1 on error.
+ */
+typedef long (*jh_pieces_reader)(void *ctx, void *buf, size_t len);
+
+/*
+ * Hashes the stream and stores the digests, out_size / 8 bytes each, in
+ * a buffer allocated with malloc(), which the caller frees. threads is
+ * the number of hashing threads, or 0 for one per online CPU. Returns
+ * the number of pieces, or -1 on a read error, a bad output size, a
+ * zero piece size or allocation failure.
+ */
+long jh_pieces(jh_pieces_reader rd, void *ctx, size_t piece_size,
+    unsigned out_size, unsigned threads, unsigned char **digests);
+
+/*
+ * Like jh_pieces(), but cuts the stream into content-defined chunks
+ * with FastCDC: a Gear rolling hash over the last 32 bytes picks the
+ * boundaries, and chunks are between min and max bytes (the last one
+ * may be shorter), avg on average. The chunk lengths are stored in a
+ * second buffer allocated with malloc(). Returns the number of chunks,
+ * or -1 on a read error, bad sizes or allocation failure; avg is
+ * between 64 bytes and 256 MiB.
+ */
+long jh_chunks(jh_pieces_reader rd, void *ctx, size_t min, size_t avg,
+    size_t max, unsigned out_size, unsigned threads, size_t **lengths,
+    unsigned char **digests);
+
+#endif
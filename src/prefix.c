@@ -0,0 +1,178 @@
+/*
+ * LRU cache of JH contexts keyed by message prefix; see prefix.h.
+ *
+ * Entries live in a chained hash table and on a doubly linked list in
+ * order of use, with the most recently used entry at the head.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "prefix.h"
+
+typedef struct jh_prefix_entry {
+    struct jh_prefix_entry *chain;        /* next in hash bucket */
+    struct jh_prefix_entry *prev, *next;  /* LRU list */
+    size_t hash;
+    size_t len;
+    unsigned char *prefix;
+    sph_jh_context sc;
+} jh_prefix_entry;
+
+struct jh_prefix_cache {
+    jh_prefix_entry **buckets;
+    size_t mask;
+    jh_prefix_entry *head, *tail;
+    size_t count, capacity;
+    size_t hits, misses;
+    unsigned out_size;
+};
+
+/* FNV-1a */
+static size_t
+prefix_hash (const unsigned char *p, size_t len) {
+    size_t h = (size_t)2166136261U;
+    while (len--)
+        h = (h ^ *p++) * (size_t)16777619U;
+    return h;
+}
+
+jh_prefix_cache *
+jh_prefix_cache_new (unsigned out_size, size_t capacity) {
+    jh_prefix_cache *pc;
+    size_t nbuckets = 16;
+    sph_jh_context sc;
+
+    if (sph_jh_init_size(&sc, out_size) < 0 || ! capacity
+        || capacity > JH_PREFIX_MAX_CAPACITY)
+        return NULL;
+    while (nbuckets < capacity * 2) {
+        if (nbuckets > (size_t)-1 / 2)
+            return NULL;
+        nbuckets <<= 1;
+    }
+    pc = calloc(1, sizeof *pc);
+    if (! pc)
+        return NULL;
+    pc->buckets = calloc(nbuckets, sizeof *pc->buckets);
+    if (! pc->buckets) {
+        free(pc);
+        return NULL;
+    }
+    pc->mask = nbuckets - 1;
+    pc->capacity = capacity;
+    pc->out_size = out_size;
+    return pc;
+}
+
+static void
+unlink_lru (jh_prefix_cache *pc, jh_prefix_entry *e) {
+    if (e->prev)
+        e->prev->next = e->next;
+    else
+        pc->head = e->next;
+    if (e->next)
+        e->next->prev = e->prev;
+    else
+        pc->tail = e->prev;
+}
+
+static void
+push_lru (jh_prefix_cache *pc, jh_prefix_entry *e) {
+    e->prev = NULL;
+    e->next = pc->head;
+    if (pc->head)
+        pc->head->prev = e;
+    else
+        pc->tail = e;
+    pc->head = e;
+}
+
+static void
+evict (jh_prefix_cache *pc, jh_prefix_entry *e) {
+    jh_prefix_entry **pp = &pc->buckets[e->hash & pc->mask];
+    while (*pp != e)
+        pp = &(*pp)->chain;
+    *pp = e->chain;
+    unlink_lru(pc, e);
+    pc->count--;
+    free(e->prefix);
+    free(e);
+}
+
+void
+jh_prefix_cache_clear (jh_prefix_cache *pc) {
+    while (pc->tail)
+        evict(pc, pc->tail);
+}
+
+void
+jh_prefix_cache_free (jh_prefix_cache *pc) {
+    if (! pc)
+        return;
+    jh_prefix_cache_clear(pc);
+    free(pc->buckets);
+    free(pc);
+}
+
+const sph_jh_context *
+jh_prefix_cache_get (jh_prefix_cache *pc, const void *prefix, size_t len) {
+    size_t hash = prefix_hash(prefix, len);
+    jh_prefix_entry *e = pc->buckets[hash & pc->mask];
+
+    for (; e; e = e->chain) {
+        if (e->hash == hash && e->len == len
+            && ! memcmp(e->prefix, prefix, len))
+        {
+            pc->hits++;
+            if (e != pc->head) {
+                unlink_lru(pc, e);
+                push_lru(pc, e);
+            }
+            return &e->sc;
+        }
+    }
+
+    pc->misses++;
+    if (pc->count >= pc->capacity)
+        evict(pc, pc->tail);
+    e = malloc(sizeof *e);
+    if (! e)
+        return NULL;
+    e->prefix = malloc(len ? len : 1);
+    if (! e->prefix) {
+        free(e);
+        return NULL;
+    }
+    memcpy(e->prefix, prefix, len);
+    e->len = len;
+    e->hash = hash;
+    sph_jh_init_size(&e->sc, pc->out_size);
+    sph_jh(&e->sc, prefix, len);
+
+    e->chain = pc->buckets[hash & pc->mask];
+    pc->buckets[hash & pc->mask] = e;
+    push_lru(pc, e);
+    pc->count++;
+    return &e->sc;
+}
+
+unsigned
+jh_prefix_cache_out_size (const jh_prefix_cache *pc) {
+    return pc->out_size;
+}
+
+size_t
+jh_prefix_cache_count (const jh_prefix_cache *pc) {
+    return pc->count;
+}
+
+size_t
+jh_prefix_cache_hits (const jh_prefix_cache *pc) {
+    return pc->hits;
+}
+
+size_t
+jh_prefix_cache_misses (const jh_prefix_cache *pc) {
+    return pc->misses;
+}
@@ -0,0 +1,45 @@
+/*
+ * LRU cache of JH contexts keyed by message prefix.
+ *
+ * When many messages share one of a few prefixes, hashing a message
+ * from the cached context after its prefix skips the compressions for
+ * the prefix's whole blocks; any trailing partial block of the prefix
+ * is cached in the context's buffer as well.
+ */
+
+#ifndef JH_PREFIX_H__
+#define JH_PREFIX_H__
+
+#include <stddef.h>
+#include "sph_jh.h"
+
+typedef struct jh_prefix_cache jh_prefix_cache;
+
+/* The largest capacity; the hash table has two buckets per entry. */
+#define JH_PREFIX_MAX_CAPACITY  ((size_t)-1 / 4)
+
+/*
+ * Returns NULL on a bad output size, a capacity of 0 or above
+ * JH_PREFIX_MAX_CAPACITY, or allocation failure.
+ */
+jh_prefix_cache *jh_prefix_cache_new(unsigned out_size, size_t capacity);
+
+void jh_prefix_cache_free(jh_prefix_cache *pc);
+
+void jh_prefix_cache_clear(jh_prefix_cache *pc);
+
+/*
+ * Returns the context after the prefix, hashing and inserting it (and
+ * evicting the least recently used entry) on a miss. The context must
+ * be copied before use, and is valid until the next call. Returns NULL
+ * if a new entry cannot be allocated.
+ */
+const sph_jh_context *jh_prefix_cache_get(jh_prefix_cache *pc,
+    const void *prefix, size_t len);
+
+unsigned jh_prefix_cache_out_size(const jh_prefix_cache *pc);
+size_t jh_prefix_cache_count(const jh_prefix_cache *pc);
+size_t jh_prefix_cache_hits(const jh_prefix_cache *pc);
+size_t jh_prefix_cache_misses(const jh_prefix_cache *pc);
+
+#endif
@@ -0,0 +1,33 @@
+/*
+ * Static tracepoints for SystemTap, bpftrace and other USDT consumers.
+ *
+ * Where <sys/sdt.h> is available, each probe compiles to a single nop
+ * and an ELF note describing where its arguments live; a tracer that
+ * attaches replaces the nop with a breakpoint, so an untraced probe
+ * costs next to nothing. Define JH_NO_PROBES to leave them out.
+ *
+ * The probes of provider digest_jh are listed in the TRACING section of
+ * lib/Digest/JH.pm.
+ */
+
+#ifndef JH_PROBES_H__
+#define JH_PROBES_H__
+
+#if !defined JH_NO_PROBES && defined __has_include
+#if __has_include(<sys/sdt.h>)
+#define JH_PROBES 1
+#include <sys/sdt.h>
+#endif
+#endif
+
+#ifdef JH_PROBES
+#define JH_PROBE1(name, a)         STAP_PROBE1(digest_jh, name, a)
+#define JH_PROBE2(name, a, b)      STAP_PROBE2(digest_jh, name, a, b)
+#define JH_PROBE3(name, a, b, c)   STAP_PROBE3(digest_jh, name, a, b, c)
+#else
+#define JH_PROBE1(name, a)         ((void)0)
+#define JH_PROBE2(name, a, b)      ((void)0)
+#define JH_PROBE3(name, a, b, c)   ((void)0)
+#endif
+
+#endif
@@ -287,4 +287,184 @@ void sph_jh512_close(void *cc, void *dst);
 void sph_jh512_addbits_and_close(
 	void *cc, unsigned ub, unsigned n, void *dst);
 
+/**
+ * Initialize a JH context for the given output size (224, 256, 384 or
+ * 512 bits), which then works with the <code>sph_jh*()</code> data
+ * functions of any size. This process performs no memory allocation.
+ *
+ * @param cc         the JH context
+ * @param out_size   the output size, in bits
+ * @return  0 on success, -1 if the output size is not supported
+ */
+int sph_jh_init_size(void *cc, unsigned out_size);
+
+/**
+ * Process some data bytes. This is the same function for all output
+ * sizes; it is acceptable that <code>len</code> is zero.
+ *
+ * @param cc     the JH context
+ * @param data   the input data
+ * @param len    the input data length (in bytes)
+ */
+void sph_jh(void *cc, const void *data, size_t len);
+
+/**
+ * Terminate the current JH computation and output the result of the
+ * given size (224, 256, 384 or 512 bits; other values are ignored) in
+ * the provided buffer. The context is automatically reinitialized for
+ * that size.
+ *
+ * @param cc         the JH context
+ * @param dst        the destination buffer
+ * @param out_size   the output size, in bits
+ */
+void sph_jh_close_size(void *cc, void *dst, unsigned out_size);
+
+/**
+ * Compute the JH digest of one message, of the given size (224, 256,
+ * 384 or 512 bits), in a context on the stack.
+ *
+ * @param data       the message
+ * @param len        the message length (in bytes)
+ * @param dst        the destination buffer
+ * @param out_size   the output size, in bits
+ * @return  0 on success, -1 if the output size is not supported
+ */
+int sph_jh_hash(const void *data, size_t len, void *dst, unsigned out_size);
+
+/**
+ * Return the number of messages that <code>sph_jh_multi_close()</code>
+ * hashes in parallel on this CPU: 1 (no vector support compiled in),
+ * 2 (128-bit vectors) or 4 (AVX2).
+ *
+ * @return  the number of lanes
+ */
+int sph_jh_multi_lanes(void);
+
+/**
+ * Hash <code>n</code> independent messages and output their digests.
+ * Message <code>i</code> consists of the data already entered in the
+ * context <code>sc[i]</code> followed by <code>len[i]</code> bytes at
+ * <code>data[i]</code>; its digest of <code>out_size</code> bits is
+ * written at offset <code>i * out_size / 8</code> of <code>dst</code>.
+ * The contexts are not modified, and the same context may be passed for
+ * several messages. Messages are scheduled over the vector lanes as they
+ * finish, so their lengths need not be equal. Nothing is done if the
+ * output size is not 224, 256, 384 or 512.
+ *
+ * @param sc         the start context of each message
+ * @param data       the data of each message
+ * @param len        the data length of each message (in bytes)
+ * @param n          the number of messages
+ * @param dst        the destination buffer
+ * @param out_size   the output size, in bits
+ */
+void sph_jh_multi_close(const sph_jh_context *const *sc,
+	const void *const *data, const size_t *len, size_t n,
+	void *dst, unsigned out_size);
+
+/**
+ * Iterate JH on its own output. Each of the <code>n</code> digests of
+ * <code>out_size</code> bits stored consecutively in <code>buf</code>
+ * is replaced with the result of hashing it <code>count</code> times.
+ * Every step is a fixed-length hash computed without a context, and
+ * several chains are run side by side in the vector lanes. Nothing is
+ * done if the output size is not 224, 256, 384 or 512.
+ *
+ * @param buf        the digests
+ * @param n          the number of digests
+ * @param count      the number of steps
+ * @param out_size   the output size, in bits
+ */
+void sph_jh_chain(void *buf, size_t n, unsigned long count,
+	unsigned out_size);
+
+/**
+ * A fixed-length message engine: JH with a given output size, for
+ * messages of a given length, whose padding blocks are computed once.
+ * It holds no running state, so one engine may be used concurrently.
+ * Its contents are opaque.
+ */
+typedef struct {
+#ifndef DOXYGEN_IGNORE
+	size_t len, blocks;
+	unsigned out_size;
+	const void *iv;
+	unsigned char pad[128];   /* padding blocks, with zero message bytes */
+#if SPH_64
+	sph_u64 padw[16];         /* the same, as 64-bit words */
+#endif
+#endif
+} sph_jh_fixed;
+
+/**
+ * Initialize a fixed-length engine for messages of <code>len</code>
+ * bytes and the given output size (224, 256, 384 or 512 bits).
+ *
+ * @param fx         the engine
+ * @param len        the message length (in bytes)
+ * @param out_size   the output size, in bits
+ * @return  0 on success, -1 if the output size is not supported
+ */
+int sph_jh_fixed_init(sph_jh_fixed *fx, size_t len, unsigned out_size);
+
+/**
+ * Hash one message of the engine's length, and write its digest to
+ * <code>dst</code>. The message words are read directly from
+ * <code>data</code>, and only the needed blocks are compressed.
+ *
+ * @param fx     the engine
+ * @param data   the message
+ * @param dst    the destination buffer
+ */
+void sph_jh_fixed_hash(const sph_jh_fixed *fx, const void *data, void *dst);
+
+/**
+ * Hash <code>n</code> messages of the engine's length, side by side in
+ * the vector lanes. The digest of message <code>i</code> is written at
+ * offset <code>i * out_size / 8</code> of <code>dst</code>.
+ *
+ * @param fx     the engine
+ * @param data   the messages
+ * @param n      the number of messages
+ * @param dst    the destination buffer
+ */
+void sph_jh_fixed_many(const sph_jh_fixed *fx, const void *const *data,
+	size_t n, void *dst);
+
+/**
+ * Maximum size (in bytes) of a context image produced by
+ * <code>sph_jh_export()</code>.
+ */
+#define SPH_JH_EXPORT_MAX   (137 + 63)
+
+/**
+ * Write a portable image of a running JH computation (any output size)
+ * into the provided buffer, which must be at least
+ * <code>SPH_JH_EXPORT_MAX</code> bytes long. The image consists of the
+ * 1024-bit state in its canonical byte order, the block count as a
+ * 64-bit big-endian integer, one byte for the number of buffered bytes,
+ * and those bytes; it does not depend on the platform endianness or
+ * word size. The context is not modified.
+ *
+ * @param cc    the JH context
+ * @param dst   the destination buffer
+ * @return  the image length (137 to 200 bytes)
+ */
+size_t sph_jh_export(const void *cc, void *dst);
+
+/**
+ * Restore a JH context from an image produced by
+ * <code>sph_jh_export()</code>. The output size is not part of the
+ * image: the restored context must be used with the same size functions
+ * as the exported one.
+ *
+ * @param cc    the JH context
+ * @param src   the image
+ * @param len   the number of available bytes in <code>src</code>
+ * @return  the image length, or 0 if the image is truncated or invalid
+ *          (in which case the context is unchanged)
+ */
+size_t sph_jh_import(void *cc, const void *src, size_t len);
+
 #endif
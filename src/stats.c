@@ -0,0 +1,98 @@
+/*
+ * Usage counters; see stats.h.
+ */
+
+#include <string.h>
+
+#include "stats.h"
+
+#ifdef JH_STATS
+
+const char *const jh_stat_names[JH_STAT_COUNT] = {
+    "bytes", "blocks", "finals", "buffered",
+    "contexts_allocated", "contexts_freed",
+    "kernel_core", "kernel_lanes2", "kernel_lanes4",
+    "kernel_chain1", "kernel_chain2", "kernel_chain4",
+    "kernel_fixed1", "kernel_fixed2", "kernel_fixed4",
+};
+
+#if JH_STATS_TLS
+
+#include <pthread.h>
+
+__thread jh_stat_block jh_stats_mine;
+static jh_stat_block *jh_stats_threads;
+static unsigned long long jh_stats_retired[JH_STAT_COUNT];
+static pthread_mutex_t jh_stats_mu = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t jh_stats_once = PTHREAD_ONCE_INIT;
+static pthread_key_t jh_stats_key;
+
+/* at thread exit: keep the counts, forget the block */
+static void
+jh_stats_retire (void *arg) {
+    jh_stat_block *b = arg;
+    int k;
+
+    pthread_mutex_lock(&jh_stats_mu);
+    for (k = 0; k < JH_STAT_COUNT; k++)
+        jh_stats_retired[k] += b->v[k];
+    if (b->next)
+        b->next->prev = b->prev;
+    *b->prev = b->next;
+    b->live = 0;
+    pthread_mutex_unlock(&jh_stats_mu);
+}
+
+static void
+jh_stats_make_key (void) {
+    pthread_key_create(&jh_stats_key, jh_stats_retire);
+}
+
+void
+jh_stats_register (void) {
+    jh_stat_block *b = &jh_stats_mine;
+
+    pthread_once(&jh_stats_once, jh_stats_make_key);
+    pthread_mutex_lock(&jh_stats_mu);
+    b->next = jh_stats_threads;
+    b->prev = &jh_stats_threads;
+    if (b->next)
+        b->next->prev = &b->next;
+    jh_stats_threads = b;
+    b->live = 1;
+    pthread_mutex_unlock(&jh_stats_mu);
+    pthread_setspecific(jh_stats_key, b);
+}
+
+void
+jh_stats_read (unsigned long long *dst, int reset) {
+    jh_stat_block *b;
+    int k;
+
+    pthread_mutex_lock(&jh_stats_mu);
+    memcpy(dst, jh_stats_retired, sizeof jh_stats_retired);
+    for (b = jh_stats_threads; b; b = b->next)
+        for (k = 0; k < JH_STAT_COUNT; k++)
+            dst[k] += b->v[k];
+    if (reset) {
+        memset(jh_stats_retired, 0, sizeof jh_stats_retired);
+        for (b = jh_stats_threads; b; b = b->next)
+            memset(b->v, 0, sizeof b->v);
+    }
+    pthread_mutex_unlock(&jh_stats_mu);
+}
+
+#else
+
+unsigned long long jh_stats_global[JH_STAT_COUNT];
+
+void
+jh_stats_read (unsigned long long *dst, int reset) {
+    memcpy(dst, jh_stats_global, sizeof jh_stats_global);
+    if (reset)
+        memset(jh_stats_global, 0, sizeof jh_stats_global);
+}
+
+#endif
+
+#endif
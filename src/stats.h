@@ -0,0 +1,82 @@
+/*
+ * Optional usage counters, compiled in when JH_STATS is defined.
+ *
+ * Each thread counts into its own block, so the hot paths never share a
+ * cache line or take a lock. The blocks of live threads are linked in a
+ * list; when a thread exits, its counts are folded into a total for
+ * retired threads. Reading sums the total and the live blocks under a
+ * mutex. Without JH_STATS, JH_STAT_ADD compiles to nothing.
+ */
+
+#ifndef JH_STATS_H__
+#define JH_STATS_H__
+
+enum {
+    JH_STAT_BYTES,          /* message bytes hashed */
+    JH_STAT_BLOCKS,         /* 64-byte blocks compressed */
+    JH_STAT_FINALS,         /* digests output */
+    JH_STAT_BUFFERED,       /* bytes copied through a context buffer */
+    JH_STAT_CTX_ALLOC,      /* Digest::JH objects created */
+    JH_STAT_CTX_FREE,       /* and destroyed */
+    JH_STAT_KERNEL_CORE,    /* calls of each compression kernel */
+    JH_STAT_KERNEL_LANES2,
+    JH_STAT_KERNEL_LANES4,
+    JH_STAT_KERNEL_CHAIN1,
+    JH_STAT_KERNEL_CHAIN2,
+    JH_STAT_KERNEL_CHAIN4,
+    JH_STAT_KERNEL_FIXED1,
+    JH_STAT_KERNEL_FIXED2,
+    JH_STAT_KERNEL_FIXED4,
+    JH_STAT_COUNT
+};
+
+#ifdef JH_STATS
+
+#if !defined _WIN32
+#define JH_STATS_TLS 1
+#else
+#define JH_STATS_TLS 0
+#endif
+
+extern const char *const jh_stat_names[JH_STAT_COUNT];
+
+/*
+ * Stores the totals of all threads in dst, then zeroes the counters if
+ * reset is set. A count made by another thread while the counters are
+ * being reset may be lost.
+ */
+void jh_stats_read(unsigned long long *dst, int reset);
+
+#if JH_STATS_TLS
+
+typedef struct jh_stat_block {
+    unsigned long long v[JH_STAT_COUNT];
+    struct jh_stat_block *next, **prev;
+    int live;
+} jh_stat_block;
+
+extern __thread jh_stat_block jh_stats_mine;
+void jh_stats_register(void);
+
+#define JH_STAT_ADD(k, n)   do { \
+        if (! jh_stats_mine.live) \
+            jh_stats_register(); \
+        jh_stats_mine.v[k] += (n); \
+    } while (0)
+
+#else
+
+/* no thread-local storage: one unsynchronized set of counters */
+extern unsigned long long jh_stats_global[JH_STAT_COUNT];
+
+#define JH_STAT_ADD(k, n)   (jh_stats_global[k] += (n))
+
+#endif
+
+#else
+
+#define JH_STAT_ADD(k, n)   ((void)0)
+
+#endif
+
+#endif
@@ -1,6 +1,6 @@
 use strict;
 use warnings;
-use Test::More tests => 19;
+use Test::More tests => 27;
 use Digest::JH;
 
 new_ok('Digest::JH' => [$_], "algorithm $_") for qw(224 256 384 512);
@@ -29,4 +29,18 @@ for my $alg (qw(224 256 384 512)) {
     $d1->add('foobar');
     my $d2 = $d1->clone;
     is($d1->hexdigest, $d2->hexdigest, "clone of $alg");
+
+    $d1->add('foobar')->reset;
+    is(
+        $d1->clone->add('a')->hexdigest,
+        Digest::JH->new($alg)->add('a')->hexdigest,
+        "clone after reset of $alg"
+    );
+    $d1->add_bits('101');
+    $d1->digest;
+    is(
+        $d1->add('a')->hexdigest,
+        Digest::JH->new($alg)->add('a')->hexdigest,
+        "add after digest of partial byte for $alg"
+    );
 }
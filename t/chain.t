@@ -0,0 +1,40 @@
+use strict;
+use warnings;
+use Test::More;
+use Digest::JH qw(
+    jh_224 jh_256 jh_384 jh_512
+    chain chain_many
+);
+
+my %jh = (224 => \&jh_224, 256 => \&jh_256, 384 => \&jh_384,
+    512 => \&jh_512);
+
+sub reference {
+    my ($size, $seed, $count) = @_;
+    $seed = $jh{$size}->($seed) for 1 .. $count;
+    return $seed;
+}
+
+for my $size (sort keys %jh) {
+    for my $count (0, 1, 2, 3, 17) {
+        is(
+            unpack('H*', chain('seed', $count, size => $size)),
+            unpack('H*', reference($size, 'seed', $count)),
+            "size $size, $count steps"
+        );
+    }
+
+    my @seeds = map { 'x' x $_ } 0 .. 8;
+    my @got = chain_many(\@seeds, 5, size => $size);
+    is_deeply(
+        [ map { unpack 'H*', $_ } @got ],
+        [ map { unpack 'H*', reference($size, $_, 5) } @seeds ],
+        "size $size, many seeds"
+    );
+}
+
+is(length chain('seed', 1000), 64, 'defaults to JH-512');
+is(chain('seed', 1, size => 100), undef, 'invalid size');
+is_deeply([ chain_many([], 3) ], [], 'no seeds');
+
+done_testing;
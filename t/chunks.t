@@ -0,0 +1,132 @@
+use strict;
+use warnings;
+use Test::More;
+use File::Temp qw(tempfile);
+use Digest::JH qw(chunks);
+
+sub write_file {
+    my ($data) = @_;
+    my ($fh, $file) = tempfile(UNLINK => 1);
+    binmode $fh;
+    print $fh $data;
+    close $fh;
+    return $file;
+}
+
+sub mul32 {
+    my ($a, $b) = @_;
+    return (($a >> 16) * $b % 2**32 * 65536 + ($a & 0xffff) * $b) % 2**32;
+}
+
+my @gear = map {
+    my $h = mul32($_ + 1, 0x9e3779b9);
+    $h ^= $h >> 16;
+    $h = mul32($h, 0x85ebca6b);
+    $h ^= $h >> 13;
+    $h = mul32($h, 0xc2b2ae35);
+    $h ^ $h >> 16;
+} 0 .. 255;
+
+sub reference_cuts {
+    my ($data, $min, $avg, $max) = @_;
+    my $bits = 0;
+    $bits++ while 2 << $bits <= $avg;
+    my $top = sub { (0xffffffff << (32 - $_[0])) & 0xffffffff };
+    my ($mask_s, $mask_l) = ($top->($bits + 2), $top->($bits - 2));
+    my @bytes = unpack 'C*', $data;
+    my ($pos, @lengths) = (0);
+    while ($pos < @bytes) {
+        my $n = @bytes - $pos;
+        my $len = $n;
+        if ($n > $min) {
+            my $end = $n < $max ? $n : $max;
+            my $normal = $end < $avg ? $end : $avg;
+            my $h = 0;
+            $len = $end;
+            for my $i ($min .. $end - 1) {
+                $h = (($h << 1) + $gear[ $bytes[ $pos + $i ] ]) & 0xffffffff;
+                if (!($h & ($i < $normal ? $mask_s : $mask_l))) {
+                    $len = $i + 1;
+                    last;
+                }
+            }
+        }
+        push @lengths, $len;
+        $pos += $len;
+    }
+    return @lengths;
+}
+
+my $seed = 7;
+my $data = join '', map {
+    $seed = ($seed * 1103515245 + 12345) & 0x7fffffff;
+    chr($seed >> 16 & 255);
+} 1 .. 300_000;
+my $file = write_file($data);
+
+for my $sizes ([ 256, 1024, 4096 ], [ 64, 64, 64 ], [ 100, 512, 600 ]) {
+    my @chunks = chunks($file, min => $sizes->[0], avg => $sizes->[1],
+        max => $sizes->[2], threads => 1);
+    is_deeply([ map { $_->[1] } @chunks ],
+        [ reference_cuts($data, @$sizes) ], "cuts for @$sizes");
+}
+
+my @chunks = chunks($file, avg => 1024);
+is_deeply([ map { $_->[1] } @chunks ],
+    [ reference_cuts($data, 256, 1024, 8192) ], 'default min and max');
+my ($offset, $ok) = (0, 1);
+for (@chunks) {
+    my ($off, $len, $digest) = @$_;
+    $ok &&= $off == $offset
+        && $digest eq Digest::JH::jh_256(substr $data, $off, $len);
+    $offset += $len;
+}
+ok($ok, 'offsets and digests');
+is($offset, length $data, 'chunks cover the file');
+
+for my $size (224, 512) {
+    my @sized = chunks($file, avg => 1024, size => $size, threads => 3);
+    is_deeply([ map { $_->[2] } @sized ],
+        [ map { Digest::JH->new($size)->add(substr $data, $_->[0], $_->[1])
+            ->digest } @sized ], "size $size, 3 threads");
+}
+
+my $big = $data x 120;
+my @big = chunks(write_file($big), avg => 65536, threads => 2);
+is(scalar(grep { $_->[1] > 65536 * 8 } @big), 0, 'large file, max size');
+my $big_ok = 1;
+for (@big[0, 100, -1]) {
+    $big_ok &&= $_->[2] eq Digest::JH::jh_256(substr $big, $_->[0], $_->[1]);
+}
+ok($big_ok, 'large file, batch boundaries');
+
+my $edited = substr($data, 0, 150_000) . 'inserted' . substr($data, 150_000);
+my %before = map { $_->[2] => 1 } @chunks;
+my @after = chunks(write_file($edited), avg => 1024);
+my $changed = grep { !$before{ $_->[2] } } @after;
+ok($changed >= 1 && $changed <= 3, 'an insert changes few chunks');
+
+open my $fh, '<', $file or die $!;
+binmode $fh;
+is_deeply([ chunks($fh, avg => 1024) ], \@chunks, 'filehandle');
+close $fh;
+
+is_deeply([ chunks(write_file('')) ], [], 'empty file');
+is_deeply([ chunks(write_file('abc')) ], [ [ 0, 3, Digest::JH::jh_256('abc') ] ],
+    'file smaller than min');
+for my $opts (
+    [ 'avg too small', avg => 32 ],
+    [ 'min above avg', avg => 1024, min => 2048 ],
+    [ 'negative min', min => -5 ],
+    [ 'zero min', min => 0 ],
+    [ 'fractional avg', avg => 1024.5 ],
+    [ 'max too large', max => 2**32 ],
+    [ 'negative threads', threads => -1 ],
+    [ 'invalid size', size => 100 ],
+) {
+    my ($name, %opts) = @$opts;
+    ok(!eval { chunks($file, %opts); 1 }, $name);
+    like($@, qr/^Invalid options/, "$name: message");
+}
+
+done_testing;
@@ -0,0 +1,170 @@
+use strict;
+use warnings;
+use Test::More;
+use File::Temp qw(tempfile);
+use Digest::JH ();
+use Digest::JH::Delta qw(signature delta patch);
+
+sub write_file {
+    my ($data) = @_;
+    my ($fh, $file) = tempfile(UNLINK => 1);
+    binmode $fh;
+    print $fh $data;
+    close $fh;
+    return $file;
+}
+
+sub weak {
+    my ($block) = @_;
+    my ($a, $b) = (0, 0);
+    for my $c (unpack 'C*', $block) {
+        $a += $c;
+        $b += $a;
+    }
+    return ($b & 0xffff) << 16 | ($a & 0xffff);
+}
+
+sub reference_signature {
+    my ($data, $block_size, $strong_len) = @_;
+    my $sig = pack 'a4CCnNNN', 'JHRS', 1, $strong_len, 0, $block_size,
+        int(length($data) / 2**32), length($data) % 2**32;
+    for (my $i = 0; $i < length $data; $i += $block_size) {
+        my $block = substr $data, $i, $block_size;
+        $sig .= pack('N', weak($block))
+            . substr(Digest::JH->new(256)->add($block)->digest, 0,
+                $strong_len);
+    }
+    return $sig;
+}
+
+# Returns the number of copied blocks and of literal bytes.
+sub stats {
+    my ($delta) = @_;
+    my ($copied, $literal, $pos) = (0, 0, 8);
+    while ($pos < length $delta) {
+        my $type = substr $delta, $pos++, 1;
+        if ($type eq 'C') {
+            $copied += unpack 'N', substr $delta, $pos + 8, 4;
+            $pos += 12;
+        }
+        else {
+            my $len = unpack 'N', substr $delta, $pos, 4;
+            $literal += $len;
+            $pos += 4 + $len;
+        }
+    }
+    return ($copied, $literal);
+}
+
+my $seed = 1;
+my $basis = join '', map {
+    $seed = ($seed * 1103515245 + 12345) & 0x7fffffff;
+    chr($seed >> 16 & 255);
+} 1 .. 200_000;
+my $basis_file = write_file($basis);
+
+for my $block_size (7, 512, 2048, 4096) {
+    is(signature($basis_file, block_size => $block_size, strong_len => 8),
+        reference_signature($basis, $block_size, 8),
+        "signature with blocks of $block_size");
+}
+my $small = substr $basis, 0, 5000;
+is(signature(write_file($small), block_size => 1, strong_len => 4),
+    reference_signature($small, 1, 4), 'signature with blocks of 1');
+is(signature($basis_file), reference_signature($basis, 2048, 16),
+    'default options');
+is(signature($basis_file, strong_len => 33), undef, 'invalid strong_len');
+is(signature($basis_file, strong_len => 0), undef, 'zero strong_len');
+is(signature($basis_file, strong_len => -1), undef, 'negative strong_len');
+is(signature($basis_file, block_size => -1), undef, 'negative block_size');
+is(signature($basis_file, block_size => 0), undef, 'zero block_size');
+is(signature($basis_file, block_size => 2.5), undef,
+    'fractional block_size');
+is(signature($basis_file, block_size => 2**32), undef,
+    'block_size too large');
+
+my %edits = (
+    identical => $basis,
+    insert    => substr($basis, 0, 10_001) . 'inserted' . substr($basis, 10_001),
+    delete    => substr($basis, 0, 50_000) . substr($basis, 50_777),
+    modify    => do {
+        my $d = $basis;
+        substr($d, $_ * 9000, 3) = 'xyz' for 1 .. 20;
+        $d;
+    },
+    shifted   => 'prefix' . substr($basis, 1000),
+    truncated => substr($basis, 0, 123_456),
+    appended  => $basis . 'tail' x 1000,
+    reversed  => scalar reverse($basis),
+    repeated  => substr($basis, 0, 4096) x 30,
+    empty     => '',
+);
+
+for my $block_size (64, 700, 2048) {
+    my $sig = signature($basis_file, block_size => $block_size);
+    for my $name (sort keys %edits) {
+        my $new = $edits{$name};
+        my $delta = delta(write_file($new), $sig);
+        is(patch($basis_file, $delta), $new,
+            "$name, blocks of $block_size");
+    }
+}
+
+my $sig = signature($basis_file, block_size => 2048);
+my ($copied, $literal) = stats(delta($basis_file, $sig));
+is($literal, 0, 'identical file has no literals');
+is($copied, int((length($basis) + 2047) / 2048),
+    'identical file copies every block');
+is(length delta($basis_file, $sig), 8 + 13, 'identical file is one copy');
+
+($copied, $literal) = stats(delta(write_file($edits{insert}), $sig));
+is($literal, 2048 + 8, 'insert sends the block it breaks');
+
+($copied, $literal) = stats(delta(write_file($edits{reversed}), $sig));
+is($copied, 0, 'unrelated file has no copies');
+
+my $empty_basis = write_file('');
+my $empty_sig = signature($empty_basis);
+is(length $empty_sig, 20, 'signature of empty file');
+is(patch($empty_basis, delta($basis_file, $empty_sig)), $basis,
+    'delta against empty file');
+
+open my $fh, '<', $basis_file or die $!;
+binmode $fh;
+is(signature($fh, block_size => 2048), $sig, 'filehandle');
+close $fh;
+
+my ($out_fh, $out_file) = tempfile(UNLINK => 1);
+binmode $out_fh;
+ok(patch($basis_file, delta(write_file($edits{modify}), $sig), $out_fh),
+    'patch to filehandle');
+close $out_fh;
+open $fh, '<', $out_file or die $!;
+binmode $fh;
+is(do { local $/; <$fh> }, $edits{modify}, 'patched file');
+close $fh;
+
+ok(!eval { delta($basis_file, 'JHRS'); 1 }, 'invalid signature croaks');
+like($@, qr/Invalid signature/, 'invalid signature message');
+ok(!eval { patch($basis_file, 'JHRD' . pack('N', 2048) . 'X'); 1 },
+    'invalid delta croaks');
+
+my $copy_all = delta($basis_file, $sig);
+my $short_basis = write_file(substr $basis, 0, 100_000);
+ok(!eval { patch($short_basis, $copy_all); 1 }, 'truncated basis croaks');
+like($@, qr/does not match the basis/, 'truncated basis message');
+my $partial_basis = write_file(substr $basis, 0, 97 * 2048 - 1);
+ok(!eval { patch($partial_basis, $copy_all); 1 },
+    'basis missing part of a block croaks');
+
+for my $cut (1, 5, 12) {
+    my $broken = delta(write_file($edits{modify}), $sig);
+    $broken = substr $broken, 0, length($broken) - $cut;
+    my ($fh, $file) = tempfile(UNLINK => 1);
+    ok(!eval { patch($basis_file, $broken, $fh); 1 },
+        "delta cut by $cut bytes croaks");
+    close $fh;
+    is(-s $file, 0, "nothing written for a delta cut by $cut bytes");
+}
+
+done_testing;
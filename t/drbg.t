@@ -0,0 +1,92 @@
+use strict;
+use warnings;
+use Test::More;
+use Math::BigInt;
+use Digest::JH qw(jh_512);
+use Digest::JH::DRBG;
+
+# NIST SP 800-90A, section 10.1.1, with JH-512 and seedlen = 888.
+my $seedlen = 111;
+my $modulus = Math::BigInt->new(2)->bpow(8 * $seedlen);
+
+sub hash_df {
+    my $input = shift;
+    my $temp = '';
+    for (my $i = 1; length $temp < $seedlen; $i++) {
+        $temp .= jh_512(chr($i) . pack('N', 8 * $seedlen) . $input);
+    }
+    return substr $temp, 0, $seedlen;
+}
+
+sub add {
+    my $sum = Math::BigInt->new(0);
+    $sum->badd(Math::BigInt->from_hex(unpack 'H*', $_)) for @_;
+    my $hex = substr $sum->bmod($modulus)->as_hex, 2;
+    return pack 'H*', ('0' x (2 * $seedlen - length $hex)) . $hex;
+}
+
+sub ref_new {
+    my ($entropy, $nonce, $pers) = @_;
+    my $v = hash_df($entropy . $nonce . $pers);
+    return { V => $v, C => hash_df("\0" . $v), counter => 1 };
+}
+
+sub ref_reseed {
+    my ($s, $entropy, $add) = @_;
+    $s->{V} = hash_df("\x01" . $s->{V} . $entropy . $add);
+    $s->{C} = hash_df("\0" . $s->{V});
+    $s->{counter} = 1;
+}
+
+sub ref_generate {
+    my ($s, $length, $add) = @_;
+    $s->{V} = add($s->{V}, jh_512("\x02" . $s->{V} . $add)) if length $add;
+    my ($data, $w) = ($s->{V}, '');
+    while (length $w < $length) {
+        $w .= jh_512($data);
+        $data = add($data, "\x01");
+    }
+    my $h = jh_512("\x03" . $s->{V});
+    $s->{V} = add($s->{V}, $h, $s->{C}, pack 'NN', 0, $s->{counter}++);
+    return substr $w, 0, $length;
+}
+
+my $entropy = join '', map { chr } 0 .. 47;
+my $nonce   = 'nonce';
+my $pers    = 'personalization';
+
+my $drbg = Digest::JH::DRBG->new($entropy, $nonce, $pers);
+my $ref  = ref_new($entropy, $nonce, $pers);
+for my $step (
+    [ 0, '' ], [ 1, '' ], [ 64, '' ], [ 65, 'additional' ], [ 1000, '' ],
+    [ 2048, 'x' x 200 ], [ 64 * 32 + 1, '' ],
+) {
+    my ($length, $add) = @$step;
+    is(
+        unpack('H*', $drbg->generate($length, $add)),
+        unpack('H*', ref_generate($ref, $length, $add)),
+        "generate $length bytes" . (length $add ? ' with input' : '')
+    );
+}
+
+$drbg->reseed('more entropy', 'additional');
+ref_reseed($ref, 'more entropy', 'additional');
+is(
+    unpack('H*', $drbg->generate(100)),
+    unpack('H*', ref_generate($ref, 100, '')),
+    'generate after reseed'
+);
+
+is($drbg->generate(65537), undef, 'request too large');
+is(length $drbg->generate(65536), 65536, 'largest request');
+
+my $a = Digest::JH::DRBG->new($entropy);
+my $b = Digest::JH::DRBG->new($entropy);
+my $c = Digest::JH::DRBG->new($entropy, '', 'other');
+my $stream = join '', map { $a->generate(2048) } 1 .. 3;
+my $read = join '', map { $b->bytes($_) } 1, 7, 100, 2000, 0, 2500, 1536;
+is(length $read, length $stream, 'buffered read length');
+ok($read eq $stream, 'buffered reads match generate(2048) stream');
+isnt($c->bytes(64), substr($stream, 0, 64), 'personalization string');
+
+done_testing;
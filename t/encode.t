@@ -0,0 +1,42 @@
+use strict;
+use warnings;
+use Test::More;
+use MIME::Base64 qw(encode_base64);
+use Digest::JH qw(
+    jh_224 jh_224_hex jh_224_base64
+    jh_256 jh_256_hex jh_256_base64
+    jh_384 jh_384_hex jh_384_base64
+    jh_512 jh_512_hex jh_512_base64
+);
+
+my %func = (
+    224 => [ \&jh_224, \&jh_224_hex, \&jh_224_base64 ],
+    256 => [ \&jh_256, \&jh_256_hex, \&jh_256_base64 ],
+    384 => [ \&jh_384, \&jh_384_hex, \&jh_384_base64 ],
+    512 => [ \&jh_512, \&jh_512_hex, \&jh_512_base64 ],
+);
+
+for my $alg (sort keys %func) {
+    my ($bin, $hex, $b64) = @{ $func{$alg} };
+    for my $msg ('', 'abc', map { join '', map { chr rand 256 } 1 .. $_ }
+        1, 63, 64, 65, 1000)
+    {
+        my $digest = $bin->($msg);
+        my $padded = encode_base64($digest, '');
+        (my $unpadded = $padded) =~ s/=+$//;
+
+        my $len = length $msg;
+        is($hex->($msg), unpack('H*', $digest), "hex $alg, $len bytes");
+        is($b64->($msg), $unpadded, "base64 $alg, $len bytes");
+
+        my $ctx = Digest::JH->new($alg);
+        is(
+            $ctx->add($msg)->base64_padded_digest, $padded,
+            "base64_padded_digest $alg, $len bytes"
+        );
+        is($ctx->add($msg)->b64digest, $unpadded,
+            "b64digest $alg, $len bytes");
+    }
+}
+
+done_testing;
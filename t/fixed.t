@@ -0,0 +1,44 @@
+use strict;
+use warnings;
+use Test::More;
+use Digest::JH qw(fixed);
+use Digest::JH::Fixed;
+
+for my $size (224, 256, 384, 512) {
+    for my $length (0, 1, 32, 47, 48, 63, 64, 65, 127, 128, 129, 200) {
+        my $engine = Digest::JH::Fixed->new($length, $size);
+        my @messages = map { chr(65 + $_) x $length } 0 .. 6;
+        my @expected = map {
+            Digest::JH->new($size)->add($_)->hexdigest
+        } @messages;
+        is($engine->hexdigest($messages[0]), $expected[0],
+            "size $size, length $length");
+        is_deeply([ $engine->hexdigest_many(\@messages) ], \@expected,
+            "size $size, length $length, many");
+    }
+}
+
+my $engine = fixed(65, 256);
+isa_ok($engine, 'Digest::JH::Fixed');
+is($engine->length, 65, 'length');
+is($engine->hashsize, 256, 'hashsize');
+is($engine->algorithm, 256, 'algorithm');
+
+my $node = "\x01" . 'a' x 64;
+my $digest = Digest::JH->new(256)->add($node)->digest;
+is($engine->($node), $digest, 'callable');
+is($engine->digest($node), $digest, 'digest');
+is($engine->b64digest($node), Digest::JH->new(256)->add($node)->b64digest,
+    'b64digest');
+is($engine->digest('short'), undef, 'wrong length');
+is_deeply(
+    [ $engine->digest_many([ $node, 'short', $node ]) ],
+    [ $digest, undef, $digest ],
+    'wrong length in many'
+);
+is_deeply([ $engine->digest_many([]) ], [], 'no messages');
+
+is(fixed(32)->hashsize, 512, 'defaults to 512');
+is(Digest::JH::Fixed->new(32, 100), undef, 'invalid size');
+
+done_testing;
@@ -0,0 +1,44 @@
+use strict;
+use warnings;
+use Test::More;
+use Digest::JH;
+
+for my $alg (qw(224 256 384 512)) {
+    my $data = join '', map { chr rand 256 } 1 .. 300;
+    for my $split (0, 1, 63, 64, 65, 200) {
+        my $ctx = Digest::JH->new($alg)->add(substr $data, 0, $split);
+        my $frozen = $ctx->freeze;
+        is(length $frozen, 141 + $split % 64, "image size, $alg at $split");
+
+        my $thawed = Digest::JH->thaw($frozen);
+        isa_ok($thawed, 'Digest::JH');
+        is($thawed->hashsize, $alg, "hashsize of thawed $alg");
+        is(
+            $thawed->add(substr $data, $split)->hexdigest,
+            Digest::JH->new($alg)->add($data)->hexdigest,
+            "resume $alg at $split"
+        );
+        is($ctx->freeze, $frozen, "freeze leaves $alg state intact");
+    }
+}
+
+my $image = Digest::JH->new(512)->freeze;
+is(
+    unpack('H*', substr $image, 0, 12), '4a4801406fd14b963e00aa17',
+    'header and state are stored in canonical byte order'
+);
+
+my $partial = Digest::JH->new(256)->add_bits('101');
+is($partial->freeze, undef, 'cannot freeze after a partial byte');
+
+my $good = Digest::JH->new(256)->add('abc')->freeze;
+is(Digest::JH->thaw(''), undef, 'empty image');
+is(Digest::JH->thaw(substr $good, 0, -1), undef, 'truncated image');
+is(Digest::JH->thaw($good . 'x'), undef, 'trailing garbage');
+is(Digest::JH->thaw('XY' . substr $good, 2), undef, 'bad magic');
+is(Digest::JH->thaw(substr($good, 0, 2) . "\x02" . substr $good, 3),
+    undef, 'unknown version');
+is(Digest::JH->thaw(substr($good, 0, 3) . "\x21" . substr $good, 4),
+    undef, 'bad digest size');
+
+done_testing;
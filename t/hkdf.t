@@ -0,0 +1,71 @@
+use strict;
+use warnings;
+use Test::More;
+use Digest::JH qw(hkdf hkdf_extract hkdf_expand);
+use Digest::JH::HMAC qw(
+    hmac_jh_224 hmac_jh_256 hmac_jh_384 hmac_jh_512
+);
+
+my %prf = (224 => \&hmac_jh_224, 256 => \&hmac_jh_256,
+    384 => \&hmac_jh_384, 512 => \&hmac_jh_512);
+
+# RFC 5869, section 2
+sub reference {
+    my ($size, $ikm, $salt, $info, $length) = @_;
+    my $prf = $prf{$size};
+    $salt = "\0" x ($size / 8) unless length $salt;
+    my $prk = $prf->($ikm, $salt);
+    my ($okm, $t) = ('', '');
+    for (my $i = 1; length $okm < $length; $i++) {
+        $t = $prf->($t . $info . chr $i, $prk);
+        $okm .= $t;
+    }
+    return substr $okm, 0, $length;
+}
+
+my $ikm  = "\x0b" x 22;
+my $salt = pack 'H*', '000102030405060708090a0b0c';
+my $info = pack 'H*', 'f0f1f2f3f4f5f6f7f8f9';
+
+for my $size (sort keys %prf) {
+    for my $length (0, 1, 42, $size / 8, $size / 8 + 1, 300) {
+        is(
+            unpack('H*', hkdf($ikm, $salt, $info, $length, size => $size)),
+            unpack('H*', reference($size, $ikm, $salt, $info, $length)),
+            "size $size, $length bytes"
+        );
+    }
+    is(
+        unpack('H*', hkdf($ikm, '', '', 42, size => $size)),
+        unpack('H*', reference($size, $ikm, '', '', 42)),
+        "size $size, empty salt and info"
+    );
+    is(
+        length hkdf($ikm, $salt, $info, 255 * $size / 8, size => $size),
+        255 * $size / 8, "size $size, longest output"
+    );
+    is(hkdf($ikm, $salt, $info, 255 * $size / 8 + 1, size => $size), undef,
+        "size $size, output too long");
+}
+
+my $prk = hkdf_extract($ikm, $salt);
+is(length $prk, 64, 'extract defaults to JH-512');
+is(
+    unpack('H*', hkdf_expand($prk, $info, 100)),
+    unpack('H*', hkdf($ikm, $salt, $info, 100)),
+    'extract and expand compose to hkdf'
+);
+is(hkdf_extract($ikm, $salt, size => 100), undef, 'invalid size');
+{
+    my @warnings;
+    local $SIG{__WARN__} = sub { push @warnings, @_ };
+    is(hkdf($ikm, $salt, $info, 42, size => 100), undef, 'hkdf, invalid size');
+    is_deeply(\@warnings, [], 'no warnings for an invalid size');
+}
+is(hkdf('k', 's', 'i', 1e12), undef, 'length far above the limit');
+is(length hkdf('k', 's', 'i', 255 * 64), 255 * 64, 'length at the limit');
+is(hkdf('k', 's', 'i', 255 * 64 + 1), undef, 'length above the limit');
+is(hkdf('k', 's', 'i', 255 * 32 + 1, size => 256), undef,
+    'length above the limit of JH-256');
+
+done_testing;
@@ -0,0 +1,67 @@
+use strict;
+use warnings;
+use Test::More;
+use Digest::JH qw(jh_224 jh_256 jh_384 jh_512);
+use Digest::JH::HMAC qw(
+    hmac_jh_224 hmac_jh_256 hmac_jh_384 hmac_jh_512
+    hmac_jh_256_hex hmac_jh_256_base64
+);
+
+my %hash = (224 => \&jh_224, 256 => \&jh_256, 384 => \&jh_384,
+    512 => \&jh_512);
+my %hmac = (224 => \&hmac_jh_224, 256 => \&hmac_jh_256,
+    384 => \&hmac_jh_384, 512 => \&hmac_jh_512);
+
+# RFC 2104, with a 64-byte block.
+sub reference {
+    my ($alg, $data, $key) = @_;
+    my $h = $hash{$alg};
+    $key = $h->($key) if length $key > 64;
+    $key .= "\0" x (64 - length $key);
+    return $h->(($key ^ ("\x5c" x 64)) . $h->(($key ^ ("\x36" x 64)) . $data));
+}
+
+my @keys = ('', 'key', 'k' x 64, 'K' x 65, join '', map { chr } 0 .. 199);
+my @msgs = ('', 'The quick brown fox jumps over the lazy dog', 'm' x 1000);
+
+for my $alg (sort keys %hash) {
+    for my $key (@keys) {
+        my $klen = length $key;
+        my $hmac = Digest::JH::HMAC->new($key, $alg);
+        for my $msg (@msgs) {
+            my $mlen = length $msg;
+            my $expect = reference($alg, $msg, $key);
+            is($hmac{$alg}->($msg, $key), $expect,
+                "hmac_jh_$alg, $klen byte key, $mlen byte message");
+            is($hmac->add($msg)->digest, $expect,
+                "OO $alg, $klen byte key, $mlen byte message");
+        }
+        is_deeply(
+            [ $hmac->digest_many(\@msgs) ],
+            [ map { reference($alg, $_, $key) } @msgs ],
+            "digest_many $alg, $klen byte key"
+        );
+    }
+}
+
+my $hmac = Digest::JH::HMAC->new('secret', 256);
+is($hmac->hashsize, 256, 'hashsize');
+is(hmac_jh_256_hex('abc', 'secret'), unpack('H*', reference(256, 'abc',
+    'secret')), 'hex');
+is($hmac->add('abc')->b64digest, hmac_jh_256_base64('abc', 'secret'),
+    'b64digest');
+
+$hmac->add('a');
+my $clone = $hmac->clone;
+is($clone->add('bc')->digest, hmac_jh_256('abc', 'secret'), 'clone');
+is($hmac->reset->add('x')->digest, hmac_jh_256('x', 'secret'), 'reset');
+
+$hmac->add('partial');
+is_deeply([ $hmac->hexdigest_many(['abc']) ], [ hmac_jh_256_hex('abc',
+    'secret') ], 'hexdigest_many');
+is($hmac->add('!')->digest, hmac_jh_256('partial!', 'secret'),
+    'digest_many leaves running state alone');
+
+is(Digest::JH::HMAC->new('k', 100), undef, 'invalid algorithm');
+
+done_testing;
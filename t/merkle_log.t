@@ -0,0 +1,130 @@
+use strict;
+use warnings;
+use Test::More;
+use File::Temp qw(tempdir);
+use Digest::JH;
+use Digest::JH::MerkleLog;
+
+our $bits = 256;
+
+# RFC 6962, section 2.1
+sub H { Digest::JH->new($bits)->add(@_)->digest }
+
+sub split_point {
+    my $n = shift;
+    my $k = 1;
+    $k <<= 1 while $k << 1 < $n;
+    return $k;
+}
+
+sub mth {
+    my @d = @_;
+    return H('') unless @d;
+    return H("\0", $d[0]) if @d == 1;
+    my $k = split_point(scalar @d);
+    return H("\x01", mth(@d[0 .. $k - 1]), mth(@d[$k .. $#d]));
+}
+
+sub path {
+    my ($m, @d) = @_;
+    return () if @d == 1;
+    my $k = split_point(scalar @d);
+    return $m < $k
+        ? (path($m, @d[0 .. $k - 1]), mth(@d[$k .. $#d]))
+        : (path($m - $k, @d[$k .. $#d]), mth(@d[0 .. $k - 1]));
+}
+
+sub subproof {
+    my ($m, $b, @d) = @_;
+    return $b ? () : mth(@d) if $m == @d;
+    my $k = split_point(scalar @d);
+    return $m <= $k
+        ? (subproof($m, $b, @d[0 .. $k - 1]), mth(@d[$k .. $#d]))
+        : (subproof($m - $k, 0, @d[$k .. $#d]), mth(@d[0 .. $k - 1]));
+}
+
+sub hexlist { [ map { unpack 'H*', $_ } @{ $_[0] } ] }
+
+my @leaves = map { "leaf $_" x ($_ % 5) } 0 .. 33;
+
+my $log = Digest::JH::MerkleLog->new;
+is($log->size, 0, 'empty');
+is($log->hexroot, unpack('H*', mth()), 'empty root');
+is($log->hashsize, 256, 'defaults to 256');
+
+# Append in batches of varying size.
+for (my ($i, $n) = (0, 1); $i < @leaves; $i += $n, $n++) {
+    my @batch = @leaves[$i .. ($i + $n > @leaves ? $#leaves : $i + $n - 1)];
+    is($log->append(@batch), $i + @batch, 'append returns size');
+}
+
+for my $size (1 .. @leaves) {
+    my @d = @leaves[0 .. $size - 1];
+    my $root = mth(@d);
+    is(unpack('H*', $log->root($size)), unpack('H*', $root), "root $size");
+    for my $m (0 .. $size - 1) {
+        my $proof = $log->inclusion_proof($m, $size);
+        is_deeply(hexlist($proof), hexlist([ path($m, @d) ]),
+            "inclusion $m in $size");
+        ok($log->verify_inclusion($leaves[$m], $m, $size, $proof, $root),
+            "verify inclusion $m in $size");
+    }
+    for my $m (1 .. $size) {
+        my $proof = $log->consistency_proof($m, $size);
+        is_deeply(hexlist($proof), hexlist([ subproof($m, 1, @d) ]),
+            "consistency $m to $size");
+        ok(Digest::JH::MerkleLog->verify_consistency($m, $size,
+            mth(@leaves[0 .. $m - 1]), $root, $proof, size => 256),
+            "verify consistency $m to $size");
+    }
+}
+
+my $root = $log->root;
+my $proof = $log->inclusion_proof(5);
+ok(!$log->verify_inclusion('other', 5, $log->size, $proof, $root),
+    'wrong leaf');
+ok(!$log->verify_inclusion($leaves[5], 6, $log->size, $proof, $root),
+    'wrong index');
+$proof = $log->consistency_proof(10);
+ok(!$log->verify_consistency(10, $log->size, H('x'), $root, $proof),
+    'wrong old root');
+is($log->leaf_hash(3), H("\0", $leaves[3]), 'leaf_hash');
+is($log->leaf_hash(scalar @leaves), undef, 'leaf_hash out of range');
+is($log->inclusion_proof(5, 5), undef, 'index not in tree');
+is($log->consistency_proof(0), undef, 'empty old tree');
+is($log->root(@leaves + 1), undef, 'root of a larger tree');
+
+my $edge = Digest::JH::MerkleLog->new(size => 512, nodes => 0);
+$edge->append($_) for @leaves;
+{
+    local $bits = 512;
+    is($edge->hexroot, unpack('H*', mth(@leaves)), 'frontier only, 512');
+}
+is($edge->inclusion_proof(0), undef, 'no proofs without nodes');
+is($edge->root(3), undef, 'no earlier roots without nodes');
+
+my $dir = tempdir(CLEANUP => 1);
+my $file = "$dir/log";
+{
+    my $log = Digest::JH::MerkleLog->new(file => $file);
+    ok($log, 'file log');
+    $log->append(@leaves[0 .. 28]);
+    $log->append(@leaves);
+    ok($log->sync, 'sync');
+}
+{
+    my $log = Digest::JH::MerkleLog->new(file => $file);
+    my @all = (@leaves[0 .. 28], @leaves);
+    is($log->size, scalar @all, 'reopened size');
+    is($log->hexroot, unpack('H*', mth(@all)), 'reopened root');
+    $log->append('more');
+    is($log->hexroot, unpack('H*', mth(@all, 'more')),
+        'append after reopen');
+    is_deeply(hexlist($log->inclusion_proof(7)),
+        hexlist([ path(7, @all, 'more') ]), 'proof after reopen');
+}
+is(Digest::JH::MerkleLog->new(file => $file, size => 512), undef,
+    'size mismatch');
+is(Digest::JH::MerkleLog->new(size => 100), undef, 'invalid size');
+
+done_testing;
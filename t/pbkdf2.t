@@ -0,0 +1,73 @@
+use strict;
+use warnings;
+use Test::More;
+use Digest::JH qw(pbkdf2 pbkdf2_verify);
+use Digest::JH::HMAC qw(
+    hmac_jh_224 hmac_jh_256 hmac_jh_384 hmac_jh_512
+);
+
+my %prf = (224 => \&hmac_jh_224, 256 => \&hmac_jh_256,
+    384 => \&hmac_jh_384, 512 => \&hmac_jh_512);
+
+# RFC 8018, section 5.2
+sub reference {
+    my ($size, $password, $salt, $iterations, $dklen) = @_;
+    my $prf = $prf{$size};
+    my $dk = '';
+    for (my $i = 1; length $dk < $dklen; $i++) {
+        my $u = $prf->($salt . pack('N', $i), $password);
+        my $t = $u;
+        for (2 .. $iterations) {
+            $u = $prf->($u, $password);
+            $t ^= $u;
+        }
+        $dk .= $t;
+    }
+    return substr $dk, 0, $dklen;
+}
+
+for my $size (sort keys %prf) {
+    for my $iterations (1, 2, 5) {
+        for my $dklen (1, 16, $size / 8, $size / 8 + 1, 150) {
+            is(
+                unpack('H*', pbkdf2('password', 'salt', $iterations, $dklen,
+                    size => $size)),
+                unpack('H*', reference($size, 'password', 'salt',
+                    $iterations, $dklen)),
+                "size $size, $iterations iterations, $dklen bytes"
+            );
+        }
+    }
+}
+
+is(
+    pbkdf2('pw' x 50, '', 3, 64),
+    reference(512, 'pw' x 50, '', 3, 64),
+    'long password, empty salt, default size'
+);
+
+my $key = pbkdf2('secret', 'NaCl', 20, 40, size => 256);
+is_deeply(
+    [ pbkdf2_verify([qw(guess secret), '', 'secret!', 'secret'], 'NaCl',
+        20, $key, size => 256) ],
+    [ !1, 1, !1, !1, 1 ],
+    'pbkdf2_verify'
+);
+
+is_deeply([ pbkdf2_verify([ 'secret', '' ], 'NaCl', 20, '') ], [ !1, !1 ],
+    'pbkdf2_verify, empty key');
+is_deeply([ pbkdf2_verify([ 'secret' ], 'NaCl', 20, undef) ], [ !1 ],
+    'pbkdf2_verify, undefined key');
+is_deeply([ pbkdf2_verify([ 'secret' ], 'NaCl', 0, $key, size => 256) ],
+    [ !1 ], 'pbkdf2_verify, failed derivation');
+is_deeply([ pbkdf2_verify([ 'secret' ], 'NaCl', 20, $key, size => 100) ],
+    [ !1 ], 'pbkdf2_verify, invalid size');
+
+is(pbkdf2('p', 's', 0, 32), undef, 'zero iterations');
+is(pbkdf2('p', 's', 1, 32, size => 100), undef, 'invalid size');
+is(pbkdf2('p', 's', 1, -1), undef, 'negative length');
+is(pbkdf2('p', 's', 1, 1e15), undef, 'length too long');
+is(pbkdf2('p', 's', 1, 1e15, size => 224), undef,
+    'length too long, size 224');
+
+done_testing;
@@ -0,0 +1,36 @@
+use strict;
+use warnings;
+use Test::More;
+use Digest::JH;
+
+for my $alg (qw(224 256 384 512)) {
+    my $ctx = Digest::JH->new($alg);
+    is(
+        $ctx->peek_hexdigest, Digest::JH->new($alg)->hexdigest,
+        "peek of empty $alg"
+    );
+
+    my $data = '';
+    for my $chunk ('a', 'b' x 62, 'c', 'd' x 64, 'e' x 100) {
+        $ctx->add($chunk);
+        $data .= $chunk;
+        my $expect = Digest::JH->new($alg)->add($data);
+        my $len = length $data;
+        is($ctx->peek_digest, $expect->clone->digest,
+            "peek_digest $alg, $len bytes");
+        is($ctx->peek_hexdigest, $expect->clone->hexdigest,
+            "peek_hexdigest $alg, $len bytes");
+        is($ctx->peek_b64digest, $expect->clone->b64digest,
+            "peek_b64digest $alg, $len bytes");
+    }
+    is(
+        $ctx->hexdigest, Digest::JH->new($alg)->add($data)->hexdigest,
+        "state intact after peeks for $alg"
+    );
+
+    $ctx->add_bits('1011');
+    my $peek = $ctx->peek_hexdigest;
+    is($ctx->hexdigest, $peek, "peek after add_bits for $alg");
+}
+
+done_testing;
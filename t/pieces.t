@@ -0,0 +1,84 @@
+use strict;
+use warnings;
+use Test::More;
+use File::Temp qw(tempfile);
+use Digest::JH qw(pieces verify_pieces);
+
+my $data = join '', map { chr(($_ * 7 + ($_ >> 8)) & 255) } 0 .. 300_000;
+my ($fh, $file) = tempfile(UNLINK => 1);
+binmode $fh;
+print $fh $data;
+close $fh;
+
+sub reference {
+    my ($data, $piece_size, $size) = @_;
+    my $digests = '';
+    for (my $i = 0; $i < length $data; $i += $piece_size) {
+        $digests .= Digest::JH->new($size)->add(substr $data, $i, $piece_size)
+            ->digest;
+    }
+    return $digests;
+}
+
+for my $size (224, 256, 512) {
+    for my $piece_size (1000, 65536, 300_001, 1 << 20) {
+        for my $threads (1, 3) {
+            is(
+                unpack('H*', pieces($file, piece_size => $piece_size,
+                    size => $size, threads => $threads)),
+                unpack('H*', reference($data, $piece_size, $size)),
+                "size $size, pieces of $piece_size, $threads threads"
+            );
+        }
+    }
+}
+
+my $digests = reference($data, 16384, 256);
+is(pieces($file, piece_size => 16384), $digests, 'default size is 256');
+open $fh, '<', $file or die $!;
+binmode $fh;
+is(pieces($fh, piece_size => 16384), $digests, 'filehandle');
+close $fh;
+
+my ($empty_fh, $empty) = tempfile(UNLINK => 1);
+close $empty_fh;
+is(pieces($empty), '', 'empty file');
+
+is_deeply([ verify_pieces($file, $digests, piece_size => 16384) ], [],
+    'verify good file');
+my $bad = $digests;
+substr($bad, 3 * 32, 1) ^= "\x01";
+substr($bad, 17 * 32, 1) ^= "\x01";
+is_deeply([ verify_pieces($file, $bad, piece_size => 16384) ], [ 3, 17 ],
+    'verify reports bad pieces');
+is_deeply(
+    [ verify_pieces($file, substr($digests, 0, 16 * 32),
+        piece_size => 16384) ],
+    [ 16 .. 18 ], 'verify reports missing digests'
+);
+is_deeply(
+    [ verify_pieces($file, $digests . 'x' x 64, piece_size => 16384) ],
+    [ 19, 20 ], 'verify reports missing pieces'
+);
+
+{
+    my @warnings;
+    local $SIG{__WARN__} = sub { push @warnings, @_ };
+    is_deeply([ verify_pieces($file, substr($digests, 0, 5 * 32 + 7),
+        piece_size => 16384) ], [ 5 .. 18 ], 'verify short digest list');
+    is_deeply(\@warnings, [], 'no warnings for a short digest list');
+}
+ok(!eval { verify_pieces($file, 'garbage' x 10, size => 100); 1 },
+    'verify croaks on invalid options');
+
+is(pieces($file, size => 100), undef, 'invalid size');
+is(pieces($file, piece_size => -1), undef, 'negative piece size');
+is(pieces($file, piece_size => 0), undef, 'zero piece size');
+is(pieces($file, piece_size => 1.5), undef, 'fractional piece size');
+is(pieces($file, piece_size => 1 << 31), undef, 'piece size too large');
+is(pieces($file, threads => -1), undef, 'negative threads');
+ok(!eval { verify_pieces($file, '', piece_size => -1); 1 },
+    'verify_pieces croaks on an invalid piece size');
+ok(!eval { pieces("$file.missing"); 1 }, 'croaks on a missing file');
+
+done_testing;
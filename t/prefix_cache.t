@@ -0,0 +1,47 @@
+use strict;
+use warnings;
+use Test::More;
+use Digest::JH::PrefixCache;
+
+for my $alg (qw(224 256 384 512)) {
+    my $cache = Digest::JH::PrefixCache->new($alg, 2);
+    is($cache->hashsize, $alg, "hashsize $alg");
+    for my $prefix ('', 'p' x 63, 'q' x 128, 'r' x 130) {
+        for my $data ('', 'x', 'y' x 200) {
+            my $expect = Digest::JH->new($alg)->add($prefix, $data);
+            my $plen = length $prefix;
+            my $dlen = length $data;
+            is($cache->hexdigest($prefix, $data), $expect->clone->hexdigest,
+                "$alg, $plen byte prefix, $dlen byte data");
+            is($cache->context($prefix)->add($data)->digest,
+                $expect->digest, "context $alg, $plen, $dlen");
+        }
+    }
+}
+
+my $cache = Digest::JH::PrefixCache->new(256, 2);
+is($cache->digest('a' x 64, 'b', 'c'),
+    Digest::JH->new(256)->add('a' x 64, 'bc')->digest, 'list of data');
+is($cache->count, 1, 'count');
+is($cache->misses, 1, 'first lookup misses');
+$cache->digest('a' x 64);
+is($cache->hits, 1, 'second lookup hits');
+
+$cache->digest('b');
+$cache->digest('a' x 64);
+$cache->digest('c');
+is($cache->count, 2, 'capacity is enforced');
+$cache->digest('a' x 64);
+is($cache->hits, 3, 'recently used prefix was kept');
+$cache->digest('b');
+is($cache->misses, 4, 'least recently used prefix was evicted');
+
+$cache->clear;
+is($cache->count, 0, 'clear');
+
+is(Digest::JH::PrefixCache->new(100), undef, 'invalid algorithm');
+is(Digest::JH::PrefixCache->new(256, 0), undef, 'zero capacity');
+is(Digest::JH::PrefixCache->new(256, -1), undef, 'negative capacity');
+is(Digest::JH::PrefixCache->new(256, ~0), undef, 'huge capacity');
+
+done_testing;
@@ -0,0 +1,48 @@
+use strict;
+use warnings;
+use Test::More;
+use File::Temp qw(tempfile);
+use Digest::JH qw(jh_256 jh_512 resume_file);
+
+my ($fh, $path) = tempfile(UNLINK => 1);
+binmode $fh;
+
+my $data = '';
+my ($digest, $checkpoint) = resume_file($path, 256);
+is($digest, jh_256(''), 'empty file');
+
+for my $chunk ('a', 'b' x 63, 'c' x 64, 'd' x 1000, '', 'e' x 70000) {
+    print {$fh} $chunk;
+    close $fh;
+    $data .= $chunk;
+    ($digest, $checkpoint) = resume_file($path, $checkpoint);
+    is($digest, jh_256($data), 'after appending ' . length($chunk) . ' bytes');
+    open $fh, '>>', $path or die $!;
+    binmode $fh;
+}
+close $fh;
+
+is(Digest::JH->thaw($checkpoint)->bytes_hashed, length $data,
+    'checkpoint records the bytes hashed');
+
+my $ctx = Digest::JH->new(256);
+is($ctx->bytes_hashed, 0, 'bytes_hashed, new object');
+$ctx->add('x' x 100);
+is($ctx->bytes_hashed, 100, 'bytes_hashed, partial block');
+$ctx->add_bits('1');
+is($ctx->bytes_hashed, undef, 'bytes_hashed, after a partial byte');
+
+my ($d512) = resume_file($path, 512);
+is($d512, jh_512($data), 'full pass with 512');
+
+open $fh, '>', $path or die $!;
+close $fh;
+ok(!eval { resume_file($path, $checkpoint); 1 },
+    'truncated file');
+like($@, qr/shorter than the checkpoint/, 'truncation error');
+
+ok(!eval { resume_file($path, 'junk'); 1 }, 'bad checkpoint');
+ok(!eval { resume_file("$path.missing", 256); 1 },
+    'missing file');
+
+done_testing;
@@ -0,0 +1,67 @@
+use strict;
+use warnings;
+use Test::More;
+use Digest::JH qw(jh_256 stats reset_stats chain_many);
+use Digest::JH::Fixed ();
+
+plan skip_all => 'built without JH_STATS' unless defined stats();
+
+sub counted (&) {
+    my ($code) = @_;
+    reset_stats();
+    $code->();
+    return reset_stats();
+}
+
+sub kernels {
+    my ($stats, $name) = @_;
+    my $sum = 0;
+    $sum += $stats->{"kernel_$name$_"} || 0 for '', 1, 2, 4;
+    return $sum;
+}
+
+my $s = counted { jh_256('abc') };
+is($s->{bytes}, 3, 'bytes');
+is($s->{blocks}, 2, 'message and padding blocks');
+is($s->{finals}, 1, 'finals');
+is($s->{buffered}, 128, 'buffered through the context');
+is($s->{kernel_core}, 2, 'scalar kernel calls');
+is($s->{contexts_allocated}, 0, 'no object');
+
+$s = counted {
+    my $ctx = Digest::JH->new(512);
+    $ctx->add('x' x 1000);
+    my $copy = $ctx->clone;
+    $ctx->digest;
+};
+is($s->{bytes}, 1000, 'object bytes');
+is($s->{blocks}, 15 + 2, 'object blocks');
+is($s->{contexts_allocated}, 2, 'contexts allocated');
+is($s->{contexts_freed}, 2, 'contexts freed');
+
+$s = counted {
+    Digest::JH::Fixed->new(100, 256)
+        ->digest_many([ map { 'y' x 100 } 1 .. 5 ]);
+};
+is($s->{bytes}, 500, 'fixed bytes');
+is($s->{blocks}, 5 * 3, 'fixed blocks');
+is($s->{finals}, 5, 'fixed finals');
+ok(kernels($s, 'fixed') >= 2, 'fixed kernel calls');
+
+$s = counted { chain_many([ 'a', 'b' ], 3, size => 256) };
+is($s->{bytes}, 2 + 4 * 32, 'chain bytes');
+is($s->{blocks}, 2 * 2 + 4 * 2, 'chain blocks');
+is($s->{finals}, 2 + 4, 'chain finals');
+ok(kernels($s, 'chain') >= 1, 'chain kernel calls');
+
+reset_stats();
+is_deeply([ grep { stats()->{$_} } keys %{ stats() } ], [], 'reset');
+
+SKIP: {
+    skip 'no threads', 1 unless eval { require threads; 1 };
+    reset_stats();
+    threads->create(sub { jh_256('z' x 640) })->join for 1 .. 2;
+    is(stats()->{bytes}, 1280, 'counts of exited threads are kept');
+}
+
+done_testing;
@@ -0,0 +1,39 @@
+use strict;
+use warnings;
+use Test::More;
+use Digest::JH;
+
+my @suffixes = ('', 'a', 'b' x 63, 'c' x 64, 'd' x 65, 'e' x 1000,
+    map { join '', map { chr rand 256 } 1 .. rand 300 } 1 .. 20);
+
+for my $alg (qw(224 256 384 512)) {
+    for my $prefix ('', 'p', 'q' x 64, 'r' x 100) {
+        my $ctx = Digest::JH->new($alg)->add($prefix);
+        my $plen = length $prefix;
+        is_deeply(
+            [ $ctx->hexdigest_suffixes(\@suffixes) ],
+            [ map { $ctx->clone->add($_)->hexdigest } @suffixes ],
+            "hexdigest_suffixes $alg, $plen byte prefix"
+        );
+        is_deeply(
+            [ $ctx->digest_suffixes([ @suffixes[ 0 .. 2 ] ]) ],
+            [ map { $ctx->clone->add($_)->digest } @suffixes[ 0 .. 2 ] ],
+            "digest_suffixes $alg, $plen byte prefix"
+        );
+        is(
+            $ctx->hexdigest,
+            Digest::JH->new($alg)->add($prefix)->hexdigest,
+            "state intact for $alg, $plen byte prefix"
+        );
+    }
+}
+
+my $ctx = Digest::JH->new(256);
+is_deeply([ $ctx->digest_suffixes([]) ], [], 'no suffixes');
+is_deeply(
+    [ $ctx->b64digest_suffixes(['x']) ],
+    [ $ctx->clone->add('x')->b64digest ],
+    'b64digest_suffixes'
+);
+
+done_testing;